@@ -2,6 +2,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#if defined(__GNUC__) || defined(__clang__)
+#define LRU_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define LRU_PREFETCH(addr) ((void)(addr))
+#endif
+
 // TODO: Implement hash function
 // Hint: Use modulo operator with HASH_SIZE, handle negative keys
 uint32_t hash(uint32_t key)
@@ -18,6 +24,8 @@ Node* create_node(uint32_t key, void* value)
     new_node->value = value;
     new_node->prev = NULL;
     new_node->next = NULL;
+    new_node->refcount = 1;     // the cache's own reference
+    new_node->in_list = false;
 
     return new_node;
 }
@@ -37,9 +45,20 @@ lru_cache_t* lru_cache_create(uint32_t capacity)
     {
         cache->hash_table[i] = NULL;
     }
+    for( uint32_t i = 0; i<LRU_LOCK_STRIPES; i++ )
+    {
+        mtx_init( &cache->stripe_locks[i], mtx_plain );
+    }
+    mtx_init( &cache->list_lock, mtx_plain );
+    cache->value_free = free;
     return cache;
 }
 
+void lru_cache_set_value_free(lru_cache_t* cache, void (*value_free)(void*))
+{
+    cache->value_free = value_free;
+}
+
 // TODO: Remove node from doubly linked list
 // Hint: Update prev node's next pointer, update next node's prev pointer
 // Handle edge cases: node is head, node is tail
@@ -155,18 +174,251 @@ void hash_delete(lru_cache_t* cache, uint32_t key)
     }
 }
 
+static mtx_t* stripe_lock(lru_cache_t* cache, uint32_t key)
+{
+    return &cache->stripe_locks[hash( key ) % LRU_LOCK_STRIPES];
+}
+
+// Point an existing hash entry at a new node, returns the node it replaced
+static Node* hash_replace(lru_cache_t* cache, uint32_t key, Node* node)
+{
+    HashNode* hashnode = cache->hash_table[hash( key )];
+    while( hashnode )
+    {
+        if( hashnode->key == key )
+        {
+            Node* old = hashnode->node;
+            hashnode->node = node;
+            return old;
+        }
+        hashnode = hashnode->next;
+    }
+    return NULL;
+}
+
+// Drop one reference, freeing value and node with the last one
+static void node_unref(lru_cache_t* cache, Node* node)
+{
+    if( __atomic_sub_fetch( &node->refcount, 1, __ATOMIC_ACQ_REL ) == 0 )
+    {
+        if( node->value && cache->value_free )
+        {
+            cache->value_free( node->value );
+        }
+        free( node );
+    }
+}
+
+// Move to front only if an eviction/replacement has not unlinked it meanwhile
+static void touch_node(lru_cache_t* cache, Node* node)
+{
+    if( node->in_list )
+    {
+        move_to_front( cache, node );
+    }
+}
+
 // TODO: Get value from cache
 // Hint: Use hash_get to find node, return -1 if not found
 // Move node to front (mark as recently used), return value
 void* lru_cache_get(lru_cache_t* cache, uint32_t key)
 {
-   Node* node = hash_get( cache, key );
-   if( node == NULL )
-   {
+    // Same lookup as lru_cache_get_ref(): the temporary reference keeps the
+    // node alive until it has been moved to front, only the value is borrowed
+    Node* node = lru_cache_get_ref( cache, key );
+    if( node == NULL )
+    {
+        return NULL;
+    }
+    void* value = node->value;
+    node_unref( cache, node );
+    return value;
+}
+
+Node* lru_cache_get_ref(lru_cache_t* cache, uint32_t key)
+{
+    // The hash table holds a reference, so the node cannot be freed while we
+    // hold the stripe lock and take ours
+    mtx_lock( stripe_lock( cache, key ) );
+    Node* node = hash_get( cache, key );
+    if( node == NULL )
+    {
+        mtx_unlock( stripe_lock( cache, key ) );
         return NULL;
-   }
-   move_to_front( cache, node );
-   return node->value;
+    }
+    __atomic_add_fetch( &node->refcount, 1, __ATOMIC_RELAXED );
+    mtx_unlock( stripe_lock( cache, key ) );
+
+    mtx_lock( &cache->list_lock );
+    touch_node( cache, node );
+    mtx_unlock( &cache->list_lock );
+    return node;
+}
+
+bool lru_cache_contains(lru_cache_t* cache, uint32_t key)
+{
+    mtx_lock( stripe_lock( cache, key ) );
+    bool found = hash_get( cache, key ) != NULL;
+    mtx_unlock( stripe_lock( cache, key ) );
+    return found;
+}
+
+void lru_cache_release(lru_cache_t* cache, Node* ref)
+{
+    if( ref )
+    {
+        node_unref( cache, ref );
+    }
+}
+
+// Batched lookup. Three passes so the memory accesses of one key overlap with
+// the next instead of serialising on each chain walk:
+// 1. prefetch every bucket head, 2. resolve nodes stripe by stripe, taking each
+// stripe lock once, 3. read values and refresh recency for all hits under a
+// single list_lock.
+uint32_t lru_cache_get_many(lru_cache_t* cache, const uint32_t* keys, uint32_t count,
+                            void** out, uint32_t* misses)
+{
+    if( !cache || !keys || !out )
+    {
+        return 0;
+    }
+
+    uint32_t stripes_used = 0;
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        LRU_PREFETCH( &cache->hash_table[hash( keys[i] )] );
+        stripes_used |= 1u << ( hash( keys[i] ) % LRU_LOCK_STRIPES );
+    }
+
+    // 'out' holds the resolved nodes until the last pass swaps in the values
+    for( uint32_t stripe = 0; stripe < LRU_LOCK_STRIPES; stripe++ )
+    {
+        if( !( stripes_used & ( 1u << stripe ) ) )
+        {
+            continue;
+        }
+        mtx_lock( &cache->stripe_locks[stripe] );
+        for( uint32_t i = 0; i < count; i++ )
+        {
+            if( hash( keys[i] ) % LRU_LOCK_STRIPES != stripe )
+            {
+                continue;
+            }
+            Node* node = hash_get( cache, keys[i] );
+            if( node )
+            {
+                // Keeps the node alive until its recency is refreshed below
+                __atomic_add_fetch( &node->refcount, 1, __ATOMIC_RELAXED );
+                LRU_PREFETCH( node );
+            }
+            out[i] = node;
+        }
+        mtx_unlock( &cache->stripe_locks[stripe] );
+    }
+
+    uint32_t miss_count = 0;
+    mtx_lock( &cache->list_lock );
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        Node* node = (Node*)out[i];
+        if( node == NULL )
+        {
+            if( misses )
+            {
+                misses[miss_count] = keys[i];
+            }
+            miss_count++;
+            continue;
+        }
+        touch_node( cache, node );
+    }
+    mtx_unlock( &cache->list_lock );
+
+    // Outside list_lock: the last unref may run the value destructor
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        Node* node = (Node*)out[i];
+        if( node )
+        {
+            out[i] = node->value;
+            node_unref( cache, node );
+        }
+    }
+    return miss_count;
+}
+
+// Publish a new node for key, replacing any existing one, and evict the LRU
+// entry if that takes the cache over capacity. Old and evicted nodes lose the
+// cache's reference, so readers holding a ref keep their value alive.
+static Node* lru_cache_insert(lru_cache_t* cache, uint32_t key, void* value, bool take_ref)
+{
+    Node* node = create_node( key, value );
+    if( take_ref )
+    {
+        node->refcount++;
+    }
+
+    // The stripe stays locked until the node is linked, so puts of the same key
+    // cannot interleave between the hash table and the list
+    mtx_lock( stripe_lock( cache, key ) );
+    Node* old = hash_replace( cache, key, node );
+    if( !old )
+    {
+        hash_insert( cache, key, node );
+    }
+
+    Node* lru = NULL;
+    mtx_lock( &cache->list_lock );
+    if( old && old->in_list )
+    {
+        remove_node( cache, old );
+        // Stored before list_lock is released: front caches holding the old
+        // node see it as stale from here on
+        __atomic_store_n( &old->in_list, false, __ATOMIC_RELEASE );
+    }
+    else
+    {
+        cache->size++;
+    }
+    add_to_front( cache, node );
+    __atomic_store_n( &node->in_list, true, __ATOMIC_RELEASE );
+
+    if( cache->size > cache->capacity )
+    {
+        lru = cache->tail;
+        remove_node( cache, lru );
+        __atomic_store_n( &lru->in_list, false, __ATOMIC_RELEASE );
+        cache->size--;
+        // Pin it: a put of the same key may replace and unref it once we unlock
+        __atomic_add_fetch( &lru->refcount, 1, __ATOMIC_RELAXED );
+    }
+    mtx_unlock( &cache->list_lock );
+    mtx_unlock( stripe_lock( cache, key ) );
+
+    if( old )
+    {
+        node_unref( cache, old );
+    }
+    if( lru )
+    {
+        // Only the thread that takes a node out of the hash table drops the
+        // cache's reference; a concurrent put may already have replaced it
+        bool unmapped = false;
+        mtx_lock( stripe_lock( cache, lru->key ) );
+        if( hash_get( cache, lru->key ) == lru )
+        {
+            hash_delete( cache, lru->key );
+            unmapped = true;
+        }
+        mtx_unlock( stripe_lock( cache, lru->key ) );
+        if( unmapped )
+        {
+            node_unref( cache, lru );
+        }
+        node_unref( cache, lru );
+    }
+    return node;
 }
 
 // TODO: Put key-value into cache
@@ -177,36 +429,70 @@ void* lru_cache_get(lru_cache_t* cache, uint32_t key)
 //   Add new node to front, insert into hash, increment size
 void lru_cache_put(lru_cache_t* cache, uint32_t key, void* value)
 {
-   Node* node = hash_get(cache, key);
-   if (node)
-   {
-        free( node->value );
-        node->value = value;  // Update value
-        move_to_front(cache, node);
-        return; 
-   }
-
-   node = create_node(key, value);
-   if (cache->capacity == cache->size)
-   {
-        Node* lru = cache->tail;
-        hash_delete(cache, lru->key);
-        remove_node(cache, lru);
-        if (lru->value) {
-            free(lru->value);  // Only free if dynamically allocated
+    lru_cache_insert( cache, key, value, false );
+}
+
+Node* lru_cache_put_ref(lru_cache_t* cache, uint32_t key, void* value)
+{
+    return lru_cache_insert( cache, key, value, true );
+}
+
+typedef struct {
+    lru_cache_t* cache;
+    uint32_t key;
+    uint32_t hits;      // since the shared list last saw this key
+    Node* ref;
+} lru_front_slot_t;
+
+static _Thread_local lru_front_slot_t front_slots[LRU_FRONT_SLOTS];
+
+void* lru_front_get(lru_cache_t* cache, uint32_t key)
+{
+    lru_front_slot_t* slot = &front_slots[key & ( LRU_FRONT_SLOTS - 1 )];
+    // A node leaves the list exactly once, when it is replaced or evicted, so
+    // its own in_list flag is the version: only writers of this key touch it
+    if( slot->ref && slot->cache == cache && slot->key == key &&
+        __atomic_load_n( &slot->ref->in_list, __ATOMIC_ACQUIRE ) )
+    {
+        // Keep hot keys from drifting to the tail while only front hits see them
+        if( ++slot->hits >= LRU_FRONT_PROMOTE_EVERY )
+        {
+            slot->hits = 0;
+            mtx_lock( &cache->list_lock );
+            touch_node( cache, slot->ref );
+            mtx_unlock( &cache->list_lock );
+        }
+        return slot->ref->value;
+    }
+
+    if( slot->ref )
+    {
+        lru_cache_release( slot->cache, slot->ref );
+    }
+    slot->cache = cache;
+    slot->key = key;
+    slot->hits = 0;
+    slot->ref = lru_cache_get_ref( cache, key );
+    return slot->ref ? slot->ref->value : NULL;
+}
+
+void lru_front_flush(lru_cache_t* cache)
+{
+    for( uint32_t i = 0; i < LRU_FRONT_SLOTS; i++ )
+    {
+        if( front_slots[i].ref && front_slots[i].cache == cache )
+        {
+            lru_cache_release( cache, front_slots[i].ref );
+            front_slots[i].ref = NULL;
         }
-        free(lru);
-        cache->size--;
     }
-    add_to_front(cache, node);
-    hash_insert(cache, key, node);
-    cache->size++;
 }
 
 // TODO: Print cache contents
 // Hint: Traverse from head to tail, print key:value pairs
 void lru_cache_print(lru_cache_t* cache)
 {    
+    mtx_lock( &cache->list_lock );
     printf("Cache (size=%d, capacity=%d): ", cache->size, cache->capacity);
     Node* curr = cache->head;
     while (curr) {
@@ -214,6 +500,7 @@ void lru_cache_print(lru_cache_t* cache)
         curr = curr->next;
     }
     printf("\n");
+    mtx_unlock( &cache->list_lock );
 }
 
 // TODO: Free cache memory
@@ -229,10 +516,10 @@ void lru_cache_free(lru_cache_t* cache)
     {
         // printf("Freeing node with key: %d\n", current->key);
         Node* next = current->next;
-        if( current->value )
+        if( current->value && cache->value_free )
         {
             // printf("Freeing value for key: %d\n", current->key);
-            free( current->value );
+            cache->value_free( current->value );
         }
         free( current );
         current = next;
@@ -249,5 +536,10 @@ void lru_cache_free(lru_cache_t* cache)
             hashnode = next;
         }
     }
+    for( uint32_t i = 0; i<LRU_LOCK_STRIPES; i++ )
+    {
+        mtx_destroy( &cache->stripe_locks[i] );
+    }
+    mtx_destroy( &cache->list_lock );
     free( cache );
 }
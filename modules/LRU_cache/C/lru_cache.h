@@ -2,14 +2,23 @@
 #define LRU_CACHE_H
 
 #define HASH_SIZE 100
+#define LRU_LOCK_STRIPES 8     // hash buckets are guarded by lock (index % LRU_LOCK_STRIPES)
+#define LRU_FRONT_SLOTS 4      // per-thread direct-mapped front cache entries (power of 2)
+#define LRU_FRONT_PROMOTE_EVERY 16  // front hits between refreshes of the shared recency list
 #include <stdint.h>
+#include <stdbool.h>
+#include <threads.h>
 
 // Node in the doubly linked list
+// The cache holds one reference while the node is in the hash table, and every
+// lru_cache_get_ref() adds one. The value is freed when the last one is released.
 typedef struct Node {
     uint32_t key;
     void* value;
     struct Node* prev;
     struct Node* next;
+    uint32_t refcount;  // atomic
+    bool in_list;       // written under list_lock, read atomically by front caches
 } Node;
 
 // Hash map entry for collision handling
@@ -20,12 +29,16 @@ typedef struct HashNode {
 } HashNode;
 
 // LRU Cache structure
+// Lock order: a stripe lock may be held while taking list_lock, never the reverse.
 typedef struct {
     uint32_t capacity;
     uint32_t size;
     Node* head;  // Most recently used
     Node* tail;  // Least recently used
     HashNode* hash_table[HASH_SIZE];
+    mtx_t stripe_locks[LRU_LOCK_STRIPES];  // lookups in different stripes run in parallel
+    mtx_t list_lock;                       // recency list, head/tail and size
+    void (*value_free)(void*);             // value destructor, free() by default
 } lru_cache_t;
 
 // ========== TODO: Implement these functions ==========
@@ -39,7 +52,12 @@ Node* create_node(uint32_t key, void* value);
 // Create and initialize an LRU cache with specified capacity
 lru_cache_t* lru_cache_create(uint32_t capacity);
 
+// Set how values are destroyed when evicted, replaced or freed with the cache
+// Defaults to free(); pass NULL when the cache does not own its values
+void lru_cache_set_value_free(lru_cache_t* cache, void (*value_free)(void*));
+
 // Remove a node from the doubly linked list (doesn't free memory)
+// List helpers below expect the caller to hold list_lock
 void remove_node(lru_cache_t* cache, Node* node);
 
 // Add a node to the front of the list (marks as most recently used)
@@ -49,6 +67,7 @@ void add_to_front(lru_cache_t* cache, Node* node);
 void move_to_front(lru_cache_t* cache, Node* node);
 
 // Insert a key-node mapping uint32_to the hash table
+// Hash helpers below expect the caller to hold the key's stripe lock
 void hash_insert(lru_cache_t* cache, uint32_t key, Node* node);
 
 // Retrieve the node associated with a key from hash table
@@ -57,18 +76,60 @@ Node* hash_get(lru_cache_t* cache, uint32_t key);
 // Delete a key-node mapping from the hash table and free the hash node
 void hash_delete(lru_cache_t* cache, uint32_t key);
 
-// Get value for a key from cache, returns -1 if not found
+// Get value for a key from cache, returns NULL if not found
 // Updates the node to most recently used
+// The value is borrowed: a concurrent put/eviction may run value_free on it as
+// soon as this returns. Only safe when no other thread can evict or replace
+// the key; use lru_cache_get_ref() when other threads write to the cache
 void* lru_cache_get(lru_cache_t* cache, uint32_t key);
 
+// Get a referenced node for a key, NULL if not found. node->value stays valid
+// until lru_cache_release(), even if the entry is evicted or replaced meanwhile
+Node* lru_cache_get_ref(lru_cache_t* cache, uint32_t key);
+
+// Check whether key is cached without touching its recency
+bool lru_cache_contains(lru_cache_t* cache, uint32_t key);
+
+// Drop a reference taken by lru_cache_get_ref()/lru_cache_put_ref()
+void lru_cache_release(lru_cache_t* cache, Node* ref);
+
+// Look up 'count' keys in one pass: bucket heads are prefetched up front, each
+// lock stripe is taken once for all of its keys, hits are written to out[i]
+// (NULL on miss) and moved to front together under one list_lock.
+// Values are borrowed, as with lru_cache_get(): only safe when no other
+// thread can evict or replace the keys meanwhile.
+// Missed keys are appended to 'misses' (may be NULL) for batched loading.
+// Returns the number of misses.
+uint32_t lru_cache_get_many(lru_cache_t* cache, const uint32_t* keys, uint32_t count,
+                            void** out, uint32_t* misses);
+
 // Insert or update a key-value pair in the cache
 // Evicts least recently used item if cache is full
 void lru_cache_put(lru_cache_t* cache, uint32_t key, void* value);
 
-// Pruint32_t cache contents for debugging (head to tail)
-void lru_cache_pruint32_t(lru_cache_t* cache);
+// Same as lru_cache_put(), but also returns a reference to the new node so the
+// caller can use a freshly loaded value without racing its eviction
+Node* lru_cache_put_ref(lru_cache_t* cache, uint32_t key, void* value);
+
+// Print cache contents for debugging (head to tail)
+void lru_cache_print(lru_cache_t* cache);
+
+// Per-thread front cache: a few direct-mapped entries in thread-local storage,
+// each holding a reference to a node. A hit reads only thread-local state and
+// the node's own in_list flag, which drops when that key is replaced or
+// evicted. Every LRU_FRONT_PROMOTE_EVERY-th hit on an entry moves its node
+// to the front of the shared list, so keys served from the front cache still
+// age like any other in the LRU order.
+// The returned value stays valid until this thread's next lru_front_get() or
+// lru_front_flush(). NULL if key is not cached.
+void* lru_front_get(lru_cache_t* cache, uint32_t key);
+
+// Release this thread's front entries for cache. Every thread that used
+// lru_front_get() must call it before the cache is freed.
+void lru_front_flush(lru_cache_t* cache);
 
 // Free all memory associated with the cache
+// No references may be outstanding
 void lru_cache_free(lru_cache_t* cache);
 
 #endif // LRU_CACHE_H
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <assert.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <threads.h>
 
 // Test counter
 uint32_t test_count = 0;
@@ -48,6 +50,7 @@ void test_single_element() {
     test_header("Single Element Operations");
     
     lru_cache_t* cache = lru_cache_create(3);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     lru_cache_put(cache, 1, (void*)100);
     assert(cache->size == 1);
@@ -71,6 +74,7 @@ void test_multiple_insertions() {
     test_header("Multiple Insertions (No Eviction)");
     
     lru_cache_t* cache = lru_cache_create(5);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     lru_cache_put(cache, 1, (void*)10);
     lru_cache_put(cache, 2, (void*)20);
@@ -98,6 +102,7 @@ void test_lru_eviction() {
     test_header("LRU Eviction");
     
     lru_cache_t* cache = lru_cache_create(3);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     lru_cache_put(cache, 1, (void*)10);
     lru_cache_put(cache, 2, (void*)20);
@@ -128,6 +133,7 @@ void test_get_updates_recency() {
     test_header("Get Updates Recency");
     
     lru_cache_t* cache = lru_cache_create(3);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     lru_cache_put(cache, 1, (void*)10);
     lru_cache_put(cache, 2, (void*)20);
@@ -161,6 +167,7 @@ void test_update_existing_key() {
     test_header("Update Existing Key");
     
     lru_cache_t* cache = lru_cache_create(3);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     lru_cache_put(cache, 1, (void*)10);
     lru_cache_put(cache, 2, (void*)20);
@@ -190,6 +197,7 @@ void test_hash_collisions() {
     test_header("Hash Collision Handling");
     
     lru_cache_t* cache = lru_cache_create(10);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     // These keys will likely collide (same hash % 100)
     // 1 % 100 = 1, 101 % 100 = 1, 201 % 100 = 1
@@ -224,6 +232,7 @@ void test_capacity_one() {
     test_header("Capacity = 1 (Edge Case)");
     
     lru_cache_t* cache = lru_cache_create(1);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     lru_cache_put(cache, 1, (void*)10);
     void* v1 = lru_cache_get(cache, 1);
@@ -245,6 +254,7 @@ void test_sequential_evictions() {
     test_header("Sequential Evictions");
     
     lru_cache_t* cache = lru_cache_create(3);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     // Fill cache
     lru_cache_put(cache, 1, (void*)10);
@@ -289,6 +299,7 @@ void test_alternating_access() {
     test_header("Alternating Access Pattern");
     
     lru_cache_t* cache = lru_cache_create(2);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     lru_cache_put(cache, 1, (void*)10);
     lru_cache_put(cache, 2, (void*)20);
@@ -330,6 +341,7 @@ void test_negative_keys() {
     test_header("Negative Keys");
     
     lru_cache_t* cache = lru_cache_create(3);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     lru_cache_put(cache, -1, (void*)10);
     lru_cache_put(cache, -100, (void*)100);
@@ -351,6 +363,7 @@ void test_large_capacity() {
     test_header("Large Capacity");
     
     lru_cache_t* cache = lru_cache_create(1000);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     // Insert 500 elements
     for (uint32_t i = 0; i < 500; i++) {
@@ -375,6 +388,7 @@ void test_stress_evictions() {
     test_header("Stress Test - Many Evictions");
     
     lru_cache_t* cache = lru_cache_create(10);
+    lru_cache_set_value_free(cache, NULL);  // Values are plain integers
     
     // Insert 100 elements (90 evictions)
     for (uint32_t i = 0; i < 100; i++) {
@@ -400,7 +414,224 @@ void test_stress_evictions() {
     lru_cache_free(cache);
 }
 
-uint32_t main() {
+// Test 14: Batched lookup
+void test_get_many() {
+    test_header("Batched Get Many");
+    
+    lru_cache_t* cache = lru_cache_create(3);
+    
+    for (uint32_t i = 1; i <= 3; i++) {
+        uint32_t* val = malloc(sizeof(uint32_t));
+        *val = i * 10;
+        lru_cache_put(cache, i, val);
+    }
+    
+    uint32_t keys[4] = {3, 42, 1, 7};
+    void* out[4];
+    uint32_t misses[4];
+    uint32_t miss_count = lru_cache_get_many(cache, keys, 4, out, misses);
+    
+    assert(miss_count == 2);
+    assert(misses[0] == 42 && misses[1] == 7);
+    test_pass("Misses reported in key order");
+    
+    assert(*(uint32_t*)out[0] == 30);
+    assert(out[1] == NULL);
+    assert(*(uint32_t*)out[2] == 10);
+    assert(out[3] == NULL);
+    test_pass("Hits resolved, misses left NULL");
+    
+    // Key 2 was not in the batch, so it is now LRU and gets evicted
+    uint32_t* val = malloc(sizeof(uint32_t));
+    *val = 40;
+    lru_cache_put(cache, 4, val);
+    assert(lru_cache_get(cache, 2) == NULL);
+    assert(lru_cache_get(cache, 1) != NULL);
+    assert(lru_cache_get(cache, 3) != NULL);
+    test_pass("Batch refreshed recency of every hit");
+    
+    lru_cache_free(cache);
+}
+
+// Test 15: References outlive eviction
+void test_ref_survives_eviction() {
+    test_header("Reference Survives Eviction");
+    
+    lru_cache_t* cache = lru_cache_create(1);
+    
+    uint32_t* val = malloc(sizeof(uint32_t));
+    *val = 10;
+    lru_cache_put(cache, 1, val);
+    
+    Node* ref = lru_cache_get_ref(cache, 1);
+    assert(ref != NULL && ref->value == val);
+    
+    // Evicts key 1 while we still hold it
+    uint32_t* other = malloc(sizeof(uint32_t));
+    *other = 20;
+    lru_cache_put(cache, 2, other);
+    assert(lru_cache_get_ref(cache, 1) == NULL);
+    assert(*(uint32_t*)ref->value == 10);
+    test_pass("Evicted value still readable through reference");
+    
+    lru_cache_release(cache, ref);
+    test_pass("Release frees the evicted node");
+    
+    uint32_t* fresh = malloc(sizeof(uint32_t));
+    *fresh = 30;
+    Node* put_ref = lru_cache_put_ref(cache, 3, fresh);
+    assert(put_ref->value == fresh);
+    lru_cache_put(cache, 3, NULL);
+    assert(*(uint32_t*)put_ref->value == 30);
+    lru_cache_release(cache, put_ref);
+    test_pass("put_ref keeps replaced value alive");
+    
+    lru_cache_free(cache);
+}
+
+// Test 16: Concurrent readers and writers
+static lru_cache_t* shared_cache;
+
+static int ref_reader(void* arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < 20000; i++) {
+        uint32_t key = i % 64;
+        Node* ref = lru_cache_get_ref(shared_cache, key);
+        if (ref) {
+            assert(*(uint32_t*)ref->value == key * 10);
+            lru_cache_release(shared_cache, ref);
+        }
+    }
+    return 0;
+}
+
+static int churn_writer(void* arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < 20000; i++) {
+        uint32_t key = (i * 7) % 64;
+        uint32_t* val = malloc(sizeof(uint32_t));
+        *val = key * 10;
+        lru_cache_put(shared_cache, key, val);
+    }
+    return 0;
+}
+
+void test_concurrent_access() {
+    test_header("Concurrent Readers And Writers");
+    
+    shared_cache = lru_cache_create(16);
+    thrd_t threads[6];
+    for (int i = 0; i < 4; i++) {
+        thrd_create(&threads[i], ref_reader, NULL);
+    }
+    for (int i = 4; i < 6; i++) {
+        thrd_create(&threads[i], churn_writer, NULL);
+    }
+    for (int i = 0; i < 6; i++) {
+        thrd_join(threads[i], NULL);
+    }
+    
+    assert(shared_cache->size == 16);
+    test_pass("Size held at capacity under contention");
+    test_pass("Every referenced value stayed intact");
+    
+    lru_cache_free(shared_cache);
+}
+
+// Test 17: Per-thread front cache
+void test_front_cache() {
+    test_header("Per-Thread Front Cache");
+    
+    lru_cache_t* cache = lru_cache_create(2);
+    
+    uint32_t* first = malloc(sizeof(uint32_t));
+    *first = 10;
+    lru_cache_put(cache, 1, first);
+    
+    assert(lru_front_get(cache, 1) == first);
+    assert(lru_front_get(cache, 1) == first);
+    assert(lru_front_get(cache, 5) == NULL);
+    test_pass("Front cache hits and misses");
+    
+    // Replacing the entry must invalidate the front copy
+    uint32_t* second = malloc(sizeof(uint32_t));
+    *second = 20;
+    lru_cache_put(cache, 1, second);
+    assert(lru_front_get(cache, 1) == second);
+    test_pass("Replacement invalidates front entry");
+    
+    // Evicting key 1 must invalidate it too
+    lru_cache_put(cache, 2, malloc(sizeof(uint32_t)));
+    lru_cache_put(cache, 3, malloc(sizeof(uint32_t)));
+    assert(lru_front_get(cache, 1) == NULL);
+    test_pass("Eviction invalidates front entry");
+    
+    lru_front_flush(cache);
+    lru_cache_free(cache);
+    
+    // Key 1 is only ever hit through the front cache after key 2 goes in,
+    // so it must still get promoted or the next put would evict it
+    cache = lru_cache_create(2);
+    lru_cache_set_value_free(cache, NULL);
+    lru_cache_put(cache, 1, (void*)10);
+    assert(lru_front_get(cache, 1) == (void*)10);
+    lru_cache_put(cache, 2, (void*)20);
+    for (uint32_t i = 0; i < LRU_FRONT_PROMOTE_EVERY; i++) {
+        assert(lru_front_get(cache, 1) == (void*)10);
+    }
+    lru_cache_put(cache, 3, (void*)30);
+    assert(lru_cache_contains(cache, 1));
+    assert(!lru_cache_contains(cache, 2));
+    test_pass("Front hits refresh shared recency");
+    
+    lru_front_flush(cache);
+    lru_cache_free(cache);
+}
+
+// Test 18: Borrowed gets racing with puts
+static int borrowed_getter(void* arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < 50000; i++) {
+        uint32_t key = i % 3;
+        void* value = lru_cache_get(shared_cache, key);
+        assert(value == NULL || value == (void*)(intptr_t)(key * 10 + 1));
+    }
+    return 0;
+}
+
+static int evicting_putter(void* arg) {
+    uint32_t offset = (uint32_t)(intptr_t)arg;
+    for (uint32_t i = 0; i < 50000; i++) {
+        uint32_t key = (i + offset) % 3;
+        lru_cache_put(shared_cache, key, (void*)(intptr_t)(key * 10 + 1));
+    }
+    return 0;
+}
+
+void test_get_vs_put() {
+    test_header("Concurrent Get Versus Put");
+    
+    // Three keys over two slots: every put evicts a node a getter may be touching
+    shared_cache = lru_cache_create(2);
+    lru_cache_set_value_free(shared_cache, NULL);
+    thrd_t threads[4];
+    for (int i = 0; i < 2; i++) {
+        thrd_create(&threads[i], borrowed_getter, NULL);
+    }
+    for (int i = 2; i < 4; i++) {
+        thrd_create(&threads[i], evicting_putter, (void*)(intptr_t)i);
+    }
+    for (int i = 0; i < 4; i++) {
+        thrd_join(threads[i], NULL);
+    }
+    
+    assert(shared_cache->size == 2);
+    test_pass("Gets survived concurrent eviction");
+    
+    lru_cache_free(shared_cache);
+}
+
+int main() {
     printf("\n");
     printf("   LRU Cache Comprehensive Test Suite  \n");
     printf("\n");
@@ -418,6 +649,11 @@ uint32_t main() {
     test_negative_keys();
     test_large_capacity();
     test_stress_evictions();
+    test_get_many();
+    test_ref_survives_eviction();
+    test_concurrent_access();
+    test_front_cache();
+    test_get_vs_put();
     
     printf("\n\n");
     printf("           Test Summary                 \n");
@@ -0,0 +1,129 @@
+#ifndef EPOCH_DOMAIN_H
+#define EPOCH_DOMAIN_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <thread>
+
+/*
+* Epoch-based reclamation domain.
+* Readers pin the current global epoch in a slot while they hold pointers into
+* a shared structure. Writers tag unlinked objects with the epoch they were
+* retired in, and may free them once every pinned slot has moved past it.
+* Slots are claimed per pin, so threads never have to register or unregister.
+*/
+class EpochDomain
+{
+public:
+    static constexpr size_t MAX_READERS = 64;
+    static constexpr uint64_t IDLE = 0;
+
+    /*
+    * @brief: RAII reader critical section, releases its slot on destruction
+    * @params: None
+    * @returns: None
+    */
+    class Guard
+    {
+    public:
+        explicit Guard( EpochDomain& d ) : domain( d ), slot( d.enter() ) {}
+        ~Guard() { domain.exit( slot ); }
+        Guard( const Guard& ) = delete;
+        Guard& operator=( const Guard& ) = delete;
+    private:
+        EpochDomain& domain;
+        size_t slot;
+    };
+
+    /*
+    * @brief: Pin the current epoch for the calling thread
+    * @params: None
+    * @returns: Guard that unpins on scope exit
+    */
+    Guard pin() { return Guard( *this ); }
+
+    /*
+    * @brief: Tag for an object that was just unlinked, and advance the epoch
+    *         so later readers start past it. Caller must unlink first.
+    * @params: None
+    * @returns: epoch to store alongside the retired object
+    */
+    uint64_t retire()
+    {
+        return global_epoch.fetch_add( 1, std::memory_order_seq_cst );
+    }
+
+    /*
+    * @brief: Check whether an object retired at 'epoch' can be freed
+    * @params: epoch returned by retire()
+    * @returns: true if no reader can still hold a reference to it
+    */
+    bool isSafe( uint64_t epoch ) const
+    {
+        return epoch < minPinned();
+    }
+
+    /*
+    * @brief: Oldest epoch still pinned by a reader
+    * @params: None
+    * @returns: minimum pinned epoch, or max uint64_t if no reader is active
+    */
+    uint64_t minPinned() const
+    {
+        // Pairs with the fence in enter(): either we see the reader's slot, or
+        // the reader sees every unlink made before this call
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        uint64_t min_epoch = std::numeric_limits<uint64_t>::max();
+        for( size_t i = 0; i < MAX_READERS; i++ )
+        {
+            uint64_t e = slots[i].epoch.load( std::memory_order_acquire );
+            if( e != IDLE && e < min_epoch )
+            {
+                min_epoch = e;
+            }
+        }
+        return min_epoch;
+    }
+
+private:
+    size_t enter()
+    {
+        // Start at a per-thread hint so uncontended readers hit their own line
+        static thread_local size_t hint = std::hash<std::thread::id>{}( std::this_thread::get_id() ) % MAX_READERS;
+        for( ;; )
+        {
+            for( size_t n = 0; n < MAX_READERS; n++ )
+            {
+                size_t i = ( hint + n ) % MAX_READERS;
+                uint64_t expected = IDLE;
+                uint64_t e = global_epoch.load( std::memory_order_seq_cst );
+                if( slots[i].epoch.load( std::memory_order_relaxed ) == IDLE &&
+                    slots[i].epoch.compare_exchange_strong( expected, e, std::memory_order_seq_cst ) )
+                {
+                    std::atomic_thread_fence( std::memory_order_seq_cst );
+                    hint = i;
+                    return i;
+                }
+            }
+            // More than MAX_READERS readers inside at once, wait for a slot
+            std::this_thread::yield();
+        }
+    }
+
+    void exit( size_t slot )
+    {
+        slots[slot].epoch.store( IDLE, std::memory_order_release );
+    }
+
+    struct alignas( 64 ) Slot
+    {
+        std::atomic<uint64_t> epoch{ IDLE };
+    };
+
+    alignas( 64 ) std::atomic<uint64_t> global_epoch{ 1 };
+    Slot slots[MAX_READERS];
+};
+
+#endif
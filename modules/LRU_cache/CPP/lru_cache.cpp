@@ -2,10 +2,30 @@
 #include <thread>
 #include <vector>
 #include <chrono>
+#include <atomic>
 #include "lru_cache_template.h"
 
 using namespace std;
 
+// Counts every heap allocation so tests can check allocation-free paths
+static atomic<size_t> heap_allocations(0);
+
+void* operator new(size_t size) {
+    heap_allocations++;
+    if (void* ptr = malloc(size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
 /*
  * Multi-threaded test for LRU Cache
  * Demonstrates concurrent producers and consumers
@@ -155,12 +175,131 @@ void stress_test() {
     cout << "Stress test completed - no crashes = thread-safe!" << endl;
 }
 
+// Batched lookup: hits, misses and recency refresh
+void test_get_many() {
+    cout << "\n========== Test: Batched Get Many ==========" << endl;
+    
+    LRUCache<int> cache(3);
+    cache.put(1, 10);
+    cache.put(2, 20);
+    cache.put(3, 30);
+    
+    vector<optional<int>> out;
+    vector<int> misses = cache.get_many({3, 42, 1}, out);
+    
+    if (misses.size() != 1 || misses[0] != 42 || out[0] != 30 || out[1] || out[2] != 10) {
+        throw runtime_error("get_many returned wrong values");
+    }
+    
+    // Key 2 was not in the batch, so it is LRU now
+    cache.put(4, 40);
+    if (cache.get(2) || !cache.get(1) || !cache.get(3)) {
+        throw runtime_error("get_many did not refresh recency");
+    }
+    
+    cout << "Batched get test completed!" << endl;
+}
+
+// Readers resolve values in place while a writer keeps evicting underneath them
+void test_epoch_reads_during_eviction() {
+    cout << "\n========== Test: Epoch Reads During Eviction ==========" << endl;
+    
+    LRUCache<int> cache(8);
+    atomic<bool> done(false);
+    atomic<int> bad_reads(0);
+    
+    auto churn_writer = [&cache, &done]() {
+        for (int i = 0; i < 20000; i++) {
+            cache.put(i % 64, (i % 64) * 2);
+        }
+        done = true;
+    };
+    
+    auto in_place_reader = [&cache, &done, &bad_reads]() {
+        while (!done) {
+            for (int key = 0; key < 64; key++) {
+                cache.read(key, [&](const int& value) {
+                    if (value != key * 2) {
+                        bad_reads++;
+                    }
+                });
+            }
+        }
+    };
+    
+    vector<thread> threads;
+    threads.emplace_back(churn_writer);
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back(in_place_reader);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    
+    if (bad_reads != 0) {
+        throw runtime_error("reader observed a torn or reclaimed value");
+    }
+    cout << "Epoch read test completed!" << endl;
+}
+
+// Steady-state put/get must be served entirely from the preallocated slab
+void test_slab_no_allocations() {
+    cout << "\n========== Test: Slab Put/Get Without Allocations ==========" << endl;
+    
+    LRUCache<int> cache(32);
+    
+    // Warm up past capacity so eviction and reclaim paths are both exercised
+    for (int i = 0; i < 1000; i++) {
+        cache.put(i, i);
+    }
+    
+    size_t before = heap_allocations;
+    for (int i = 0; i < 100000; i++) {
+        cache.put(i % 100, i);
+        cache.get(i % 50);
+    }
+    size_t allocations = heap_allocations - before;
+    
+    if (allocations != 0) {
+        throw runtime_error("put/get allocated " + to_string(allocations) + " times");
+    }
+    cout << "Slab test completed!" << endl;
+}
+
+// A reader pinned across many writes, even one that writes from its own
+// callback, must not stall put() once every spare slab node is retired
+void test_put_inside_read() {
+    cout << "\n========== Test: put() While A Reader Is Pinned ==========" << endl;
+
+    LRUCache<int> cache(4);
+    cache.put(0, 0);
+    bool found = cache.read(0, [&cache](const int&) {
+        // Far more replacements than the slab has spare nodes
+        for (int i = 0; i < 200; i++) {
+            cache.put(i % 8, i);
+        }
+    });
+    optional<int> last = cache.get(7);
+    if (!found || !last || *last != 199) {
+        throw runtime_error("put() inside read() left wrong contents");
+    }
+    // Once the reader is gone the borrowed heap nodes are reclaimed
+    for (int i = 0; i < 200; i++) {
+        cache.put(i % 8, i);
+    }
+    cout << "Pinned reader test completed!" << endl;
+}
+
 int main() {
     try {
         test_single_producer_consumer();
         test_multiple_producers();
         test_multiple_producers_consumers();
         stress_test();
+        test_get_many();
+        test_epoch_reads_during_eviction();
+        test_slab_no_allocations();
+        test_put_inside_read();
         
         cout << "\n========== ALL TESTS PASSED ==========" << endl;
         cout << "LRU Cache is thread-safe!" << endl;
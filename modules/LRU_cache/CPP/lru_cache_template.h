@@ -1,24 +1,50 @@
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <thread>
+#include <vector>
+#include "epoch_domain.h"
+#include "../../aligned_malloc/aligned_allocator.h"
 using namespace std;
 
+/*
+* Readers never take cache_mutex. Lookups go through an atomically published
+* bucket index inside an epoch guard, values are read in place, and nodes are
+* never modified once published (put() on an existing key swaps in a new node).
+* Writers serialise on cache_mutex and retire unlinked nodes to the epoch
+* domain; they are recycled only after every reader that could see them is gone.
+* Readers cannot touch the recency list, so they set a 'referenced' bit and
+* eviction gives referenced nodes a second chance at the MRU end instead.
+* All nodes, sentinels included, live in one slab sized at construction: free
+* nodes are chained through 'next', and reclaimed nodes go back on that chain,
+* so put() and get() normally never call the allocator. If readers keep every
+* spare node pinned, put() takes a heap node instead of waiting under
+* cache_mutex; reclaim() deletes it once no reader can see it.
+*/
 template <typename T>
 class LRUCache
 {
 public:
     /*
     * @brief: class to hold doubly linked list node
-    *         holds key, value, pointer to previous, pointer to next
+    *         holds key, value, pointer to previous, pointer to next,
+    *         next pointer in its index bucket and the reader reference bit.
+    *         Cache-line aligned so readers setting 'referenced' on one node
+    *         do not contend with writers relinking its neighbours
     * @params: integer key 'k', Template type value 'val'
     * @returns: None
     */
-    class Node
+    class alignas( 64 ) Node
     {
     public:
         Node* prev;
         Node* next;
+        std::atomic<Node*> hnext;
+        std::atomic<bool> referenced;
         int key;
         T value;
         Node( int k = 0, T val = T() );
@@ -41,12 +67,30 @@ public:
     void put( int key, T value );
     
     /*
-    * @brief: Get value from cache_map for key
+    * @brief: Get value from cache_map for key, without taking the writer lock
     * @params: integer for key 'key'
     * @returns: template type value 'value'
     */
     std::optional<T> get( int key );
 
+    /*
+    * @brief: Read value for key in place inside an epoch guard, without copying.
+    *         'fn' must not keep a reference to the value after it returns
+    * @params: integer for key 'key', callable 'fn' taking const T&
+    * @returns: true if key was found and 'fn' was called
+    */
+    template <typename F>
+    bool read( int key, F&& fn );
+
+    /*
+    * @brief: Get values for a batch of keys inside a single epoch guard.
+    *         Nodes are resolved and prefetched first, then values are copied
+    *         and recency is refreshed in one pass
+    * @params: vector of integer keys 'keys', output vector 'out' resized to keys.size()
+    * @returns: vector of keys that missed, for batched loading
+    */
+    std::vector<int> get_many( const std::vector<int>& keys, std::vector<std::optional<T>>& out );
+
     /*
     * @brief: Prints current cache_map
     * @params: None
@@ -69,16 +113,98 @@ private:
     */
     void deleteNode( Node* node );
 
+    /*
+    * @brief: Find node for key in the bucket index, safe inside an epoch guard
+    * @params: integer for key 'key'
+    * @returns: Pointer to Node, nullptr if not found
+    */
+    Node* findNode( int key ) const;
+
+    /*
+    * @brief: Replace 'old_node' in its bucket chain with 'node', or publish
+    *         'node' at the bucket head if 'old_node' is nullptr. Writer only
+    * @params: Pointer to Node to be published, Pointer to Node it replaces
+    * @returns: None
+    */
+    void publishNode( Node* node, Node* old_node );
+
+    /*
+    * @brief: Unlink node from its bucket chain. Writer only
+    * @params: Pointer to Node to be unlinked
+    * @returns: None
+    */
+    void unpublishNode( Node* node );
+
+    /*
+    * @brief: Take a node from the slab free list and fill it. If every spare
+    *         node is still retired, allocates one on the heap. Writer only
+    * @params: integer key 'key', template type value 'value'
+    * @returns: Pointer to unpublished Node
+    */
+    Node* allocNode( int key, const T& value );
+
+    /*
+    * @brief: Hand an unlinked node to the epoch domain. Writer only
+    * @params: Pointer to unlinked Node
+    * @returns: None
+    */
+    void retireNode( Node* node );
+
+    /*
+    * @brief: Return retired nodes no reader can reach anymore to the free list. Writer only
+    * @params: None
+    * @returns: None
+    */
+    void reclaim();
+
+    /*
+    * @brief: Evict the least recently used node, giving nodes read since
+    *         they were last considered a second chance. Writer only
+    * @params: None
+    * @returns: None
+    */
+    void evict();
+
+    /*
+    * @brief: Whether node was carved from the slab rather than the heap
+    * @params: Pointer to Node
+    * @returns: true for slab nodes
+    */
+    bool inSlab( const Node* node ) const
+    {
+        std::less_equal<const Node*> le;
+        std::less<const Node*> lt;
+        return le( slab.get(), node ) && lt( node, slab.get() + slab.get_deleter().count );
+    }
+
+    size_t bucketOf( int key ) const
+    {
+        return ( static_cast<uint32_t>( key ) * 2654435761u ) >> bucket_shift;
+    }
+
 private:
+    // Spare slab nodes that may sit retired before put() has to reclaim
+    static constexpr size_t RECLAIM_BATCH = 16;
+
     Node* head;
     Node* tail;
     int cap;
-    unordered_map< int, Node* > cache_map;
+    int size = 0;
+    AlignedArray<Node> slab;
+    Node* free_list = nullptr;
+    std::unique_ptr<std::atomic<Node*>[]> buckets;
+    unsigned bucket_shift;
+    std::vector<std::pair<Node*, uint64_t>> retired;
+    EpochDomain epochs;
     mutex cache_mutex;
 };
 
 template <typename T>
 LRUCache<T>::Node::Node( int k, T val):
+    prev( nullptr ),
+    next( nullptr ),
+    hnext( nullptr ),
+    referenced( false ),
     key( k ),
     value( val )
 {
@@ -89,24 +215,56 @@ template <typename T>
 LRUCache<T>::LRUCache( int capacity ):
     cap( capacity )
 {
-    head = new Node();
-    tail = new Node();
+    // Two sentinels, 'capacity' live nodes and room for a batch of retired ones
+    size_t slab_size = size_t( std::max( capacity, 0 ) ) + RECLAIM_BATCH + 2;
+    slab = makeAlignedArray<Node, alignof( Node )>( slab_size );
+    for( size_t i = 2; i < slab_size; i++ )
+    {
+        slab[i].next = free_list;
+        free_list = &slab[i];
+    }
+    retired.reserve( slab_size );
+
+    head = &slab[0];
+    tail = &slab[1];
     head->next = tail;
     tail->prev = head;
+
+    // Power of two buckets, at least twice the capacity, indexed by the top bits of the hash
+    unsigned bits = 1;
+    while( ( size_t( 1 ) << bits ) < size_t( std::max( capacity, 1 ) ) * 2 )
+    {
+        bits++;
+    }
+    bucket_shift = 32 - bits;
+    buckets.reset( new std::atomic<Node*>[ size_t( 1 ) << bits ] );
+    for( size_t i = 0; i < ( size_t( 1 ) << bits ); i++ )
+    {
+        buckets[i].store( nullptr, std::memory_order_relaxed );
+    }
 }
 
 template <typename T>
 LRUCache<T>::~LRUCache()
 {
-    Node* curr = head->next;
-    while( curr!=tail )
+    // No reader may be inside the cache while it is destroyed; the slab
+    // releases its nodes at once, heap nodes are deleted one by one
+    for( Node* node = head->next; node != tail; )
+    {
+        Node* next = node->next;
+        if( !inSlab( node ) )
+        {
+            delete node;
+        }
+        node = next;
+    }
+    for( auto& entry : retired )
     {
-        Node* next = curr->next;
-        delete curr;
-        curr = next;
+        if( !inSlab( entry.first ) )
+        {
+            delete entry.first;
+        }
     }
-    delete head;
-    delete tail;
 }
 
 template <typename T>
@@ -130,53 +288,215 @@ void LRUCache<T>::deleteNode( Node* node )
 }
 
 template <typename T>
-std::optional<T> LRUCache<T>::get( int key )
+typename LRUCache<T>::Node* LRUCache<T>::findNode( int key ) const
 {
-    lock_guard<mutex> lock(cache_mutex);
-    if(cache_map.find( key ) != cache_map.end())
+    Node* node = buckets[bucketOf( key )].load( std::memory_order_acquire );
+    while( node && node->key != key )
     {
-        // If key exists in map, get value, and move node from wherever it is to MRU
-        T ret = cache_map[key]->value;
-        deleteNode( cache_map[key] );
-        insertNode( cache_map[key] );
-        return ret;
+        node = node->hnext.load( std::memory_order_acquire );
     }
-    return std::nullopt;
+    return node;
 }
 
 template <typename T>
-void LRUCache<T>::put( int key, T value )
+void LRUCache<T>::publishNode( Node* node, Node* old_node )
 {
-    lock_guard<mutex> lock( cache_mutex );
-    if(cache_map.find( key ) != cache_map.end())
+    std::atomic<Node*>* link = &buckets[bucketOf( node->key )];
+    if( !old_node )
+    {
+        node->hnext.store( link->load( std::memory_order_relaxed ), std::memory_order_relaxed );
+        link->store( node, std::memory_order_release );
+        return;
+    }
+    while( link->load( std::memory_order_relaxed ) != old_node )
+    {
+        link = &link->load( std::memory_order_relaxed )->hnext;
+    }
+    node->hnext.store( old_node->hnext.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+    link->store( node, std::memory_order_release );
+}
+
+template <typename T>
+void LRUCache<T>::unpublishNode( Node* node )
+{
+    std::atomic<Node*>* link = &buckets[bucketOf( node->key )];
+    while( link->load( std::memory_order_relaxed ) != node )
+    {
+        link = &link->load( std::memory_order_relaxed )->hnext;
+    }
+    // node->hnext is left intact so readers standing on it can keep walking
+    link->store( node->hnext.load( std::memory_order_relaxed ), std::memory_order_release );
+}
+
+template <typename T>
+typename LRUCache<T>::Node* LRUCache<T>::allocNode( int key, const T& value )
+{
+    if( !free_list )
+    {
+        reclaim();
+    }
+    Node* node = free_list;
+    if( node )
     {
-        // If key exists in map, remove node from linked list
-        Node* node = cache_map[key];
-        deleteNode( node );
+        free_list = node->next;
     }
     else
     {
-        // Else create new entry in map for key
-        Node* node = new Node();
-        node->key = key;
-        cache_map[key] = node;
+        // Every spare node is still visible to a reader. Waiting for it here
+        // would stall every writer behind cache_mutex, and deadlock a reader
+        // that calls put() from its callback, so borrow a node from the heap.
+        node = new Node();
     }
-    if(cache_map.size() > cap)
+
+    node->prev = nullptr;
+    node->next = nullptr;
+    node->hnext.store( nullptr, std::memory_order_relaxed );
+    node->referenced.store( false, std::memory_order_relaxed );
+    node->key = key;
+    node->value = value;
+    return node;
+}
+
+template <typename T>
+void LRUCache<T>::retireNode( Node* node )
+{
+    retired.emplace_back( node, epochs.retire() );
+}
+
+template <typename T>
+void LRUCache<T>::reclaim()
+{
+    uint64_t min_pinned = epochs.minPinned();
+    auto still_visible = std::partition( retired.begin(), retired.end(),
+        [min_pinned]( const std::pair<Node*, uint64_t>& entry ) { return entry.second >= min_pinned; } );
+    for( auto it = still_visible; it != retired.end(); ++it )
+    {
+        if( !inSlab( it->first ) )
+        {
+            delete it->first;
+            continue;
+        }
+        // Drop the old value now rather than when the node is next reused
+        it->first->value = T();
+        it->first->next = free_list;
+        free_list = it->first;
+    }
+    retired.erase( still_visible, retired.end() );
+}
+
+template <typename T>
+void LRUCache<T>::evict()
+{
+    // Bounded second chance: each node is spared at most once per eviction
+    for( int i = 0; i < size; i++ )
     {
-        // If we are at capacity, delete LRU
         Node* lru = tail->prev;
-        cache_map.erase( lru->key );
+        if( !lru->referenced.load( std::memory_order_relaxed ) )
+        {
+            break;
+        }
+        lru->referenced.store( false, std::memory_order_relaxed );
         deleteNode( lru );
-        delete( lru );
+        insertNode( lru );
+    }
+
+    Node* lru = tail->prev;
+    unpublishNode( lru );
+    deleteNode( lru );
+    retireNode( lru );
+    size--;
+}
+
+template <typename T>
+template <typename F>
+bool LRUCache<T>::read( int key, F&& fn )
+{
+    auto guard = epochs.pin();
+    Node* node = findNode( key );
+    if( !node )
+    {
+        return false;
+    }
+    if( !node->referenced.load( std::memory_order_relaxed ) )
+    {
+        node->referenced.store( true, std::memory_order_relaxed );
     }
-    // Attach new value, and put node at MRU
-    cache_map[key]->value = value;
-    insertNode( cache_map[key] );
+    fn( static_cast<const T&>( node->value ) );
+    return true;
+}
+
+template <typename T>
+std::optional<T> LRUCache<T>::get( int key )
+{
+    std::optional<T> ret;
+    read( key, [&ret]( const T& value ) { ret = value; } );
+    return ret;
+}
+
+template <typename T>
+std::vector<int> LRUCache<T>::get_many( const std::vector<int>& keys, std::vector<std::optional<T>>& out )
+{
+    std::vector<Node*> nodes( keys.size(), nullptr );
+    std::vector<int> misses;
+    out.assign( keys.size(), std::nullopt );
+
+    auto guard = epochs.pin();
+    for( size_t i = 0; i < keys.size(); i++ )
+    {
+        nodes[i] = findNode( keys[i] );
+        if( nodes[i] )
+        {
+            __builtin_prefetch( nodes[i] );
+        }
+    }
+
+    for( size_t i = 0; i < keys.size(); i++ )
+    {
+        if( !nodes[i] )
+        {
+            misses.push_back( keys[i] );
+            continue;
+        }
+        out[i] = nodes[i]->value;
+        if( !nodes[i]->referenced.load( std::memory_order_relaxed ) )
+        {
+            nodes[i]->referenced.store( true, std::memory_order_relaxed );
+        }
+    }
+    return misses;
+}
+
+template <typename T>
+void LRUCache<T>::put( int key, T value )
+{
+    lock_guard<mutex> lock( cache_mutex );
+    // Published nodes are immutable, so an update swaps in a fresh node
+    Node* node = allocNode( key, value );
+    Node* old_node = findNode( key );
+    if( old_node )
+    {
+        publishNode( node, old_node );
+        deleteNode( old_node );
+        retireNode( old_node );
+    }
+    else
+    {
+        if( size >= cap )
+        {
+            // If we are at capacity, delete LRU
+            evict();
+        }
+        publishNode( node, nullptr );
+        size++;
+    }
+    // Put node at MRU
+    insertNode( node );
 }
 
 template <typename T>
 void LRUCache<T>::print()
 {
+    lock_guard<mutex> lock( cache_mutex );
     LRUCache::Node* curr = head->next;
     cout << "cache { ";
     while(curr->key != 0)
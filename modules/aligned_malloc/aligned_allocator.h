@@ -0,0 +1,137 @@
+#ifndef ALIGNED_ALLOCATOR_H
+#define ALIGNED_ALLOCATOR_H
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+#include "aligned_malloc.h"
+
+/*
+* @brief: aligned_malloc that reports failure the C++ way
+* @params: size in bytes, power of 2 alignment
+* @returns: aligned pointer, throws std::bad_alloc on failure
+*/
+void* aligned_malloc_or_throw( std::size_t size, std::size_t alignment );
+
+/*
+* Standard allocator handing out storage from aligned_malloc, so containers
+* and arrays of T start on an 'Align' boundary (a cache line by default).
+* Stateless: any two instances compare equal and may free each other's memory.
+*/
+template <typename T, std::size_t Align = 64>
+class AlignedAllocator
+{
+    static_assert( ( Align & ( Align - 1 ) ) == 0, "Align must be a power of 2" );
+    static_assert( Align >= alignof( T ), "Align must satisfy alignof(T)" );
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+    static constexpr std::size_t alignment = Align;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Align>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator( const AlignedAllocator<U, Align>& ) noexcept {}
+
+    /*
+    * @brief: Allocate uninitialised storage for 'n' objects
+    * @params: number of objects
+    * @returns: aligned pointer, throws std::bad_array_new_length or std::bad_alloc
+    */
+    T* allocate( std::size_t n )
+    {
+        if( n > std::numeric_limits<std::size_t>::max() / sizeof( T ) )
+        {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>( aligned_malloc_or_throw( n * sizeof( T ), Align ) );
+    }
+
+    /*
+    * @brief: Release storage from allocate()
+    * @params: pointer from allocate(), object count (unused)
+    * @returns: None
+    */
+    void deallocate( T* p, std::size_t ) noexcept
+    {
+        free_aligned( p );
+    }
+};
+
+template <typename T, typename U, std::size_t Align>
+bool operator==( const AlignedAllocator<T, Align>&, const AlignedAllocator<U, Align>& ) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U, std::size_t Align>
+bool operator!=( const AlignedAllocator<T, Align>&, const AlignedAllocator<U, Align>& ) noexcept
+{
+    return false;
+}
+
+/*
+* unique_ptr deleter for arrays from makeAlignedArray: destroys the 'count'
+* elements in reverse order, then returns the storage to free_aligned.
+*/
+template <typename T>
+struct AlignedArrayDeleter
+{
+    std::size_t count = 0;
+
+    void operator()( T* p ) const noexcept
+    {
+        if( !p )
+        {
+            return;
+        }
+        for( std::size_t i = count; i > 0; i-- )
+        {
+            p[i - 1].~T();
+        }
+        free_aligned( p );
+    }
+};
+
+template <typename T>
+using AlignedArray = std::unique_ptr<T[], AlignedArrayDeleter<T>>;
+
+/*
+* @brief: Allocate and value-initialise an aligned array of 'n' T
+* @params: number of elements
+* @returns: owning AlignedArray, throws if allocation or a constructor throws
+*/
+template <typename T, std::size_t Align = 64>
+AlignedArray<T> makeAlignedArray( std::size_t n )
+{
+    AlignedAllocator<T, Align> alloc;
+    T* p = alloc.allocate( n );
+    std::size_t built = 0;
+    try
+    {
+        for( ; built < n; built++ )
+        {
+            ::new( static_cast<void*>( p + built ) ) T();
+        }
+    }
+    catch( ... )
+    {
+        AlignedArrayDeleter<T>{ built }( p );
+        throw;
+    }
+    return AlignedArray<T>( p, AlignedArrayDeleter<T>{ n } );
+}
+
+#endif
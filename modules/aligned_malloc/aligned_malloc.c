@@ -1,7 +1,109 @@
 #include "aligned_malloc.h"
+#include <stdbool.h>
 #include <stdio.h>
 
+#ifdef ALIGNED_MALLOC_STATS
+// Sits right below the aligned address; 'raw' stays last so it is still the
+// word free_aligned reads at ptr - sizeof(void*)
+typedef struct {
+    size_t size;
+    uint32_t tag;
+    uint32_t slack;
+    void* raw;
+} alloc_header_t;
+#define ALLOC_HEADER_SIZE sizeof( alloc_header_t )
+
+static alloc_stats_t stats;
+static _Thread_local int hot_path_depth;
+static const char* tag_names[ALLOC_TAG_COUNT] = { "other", "pool", "scratch", "cache", "queue" };
+
+void alloc_stats_record( alloc_tag_t tag, size_t size, size_t slack )
+{
+    uint64_t live = __atomic_add_fetch( &stats.live_bytes, size, __ATOMIC_RELAXED );
+    uint64_t peak = __atomic_load_n( &stats.peak_bytes, __ATOMIC_RELAXED );
+    while( live > peak && !__atomic_compare_exchange_n( &stats.peak_bytes, &peak, live, true,
+                                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+    {
+    }
+    __atomic_add_fetch( &stats.slack_bytes, slack, __ATOMIC_RELAXED );
+    __atomic_add_fetch( &stats.allocs, 1, __ATOMIC_RELAXED );
+    __atomic_add_fetch( &stats.tag_allocs[tag], 1, __ATOMIC_RELAXED );
+    __atomic_add_fetch( &stats.tag_live_bytes[tag], size, __ATOMIC_RELAXED );
+    if( hot_path_depth > 0 )
+    {
+        __atomic_add_fetch( &stats.hot_path_allocs, 1, __ATOMIC_RELAXED );
+    }
+    uint64_t budget = __atomic_load_n( &stats.budget_bytes, __ATOMIC_RELAXED );
+    if( budget && live > budget )
+    {
+        __atomic_add_fetch( &stats.over_budget_allocs, 1, __ATOMIC_RELAXED );
+    }
+}
+
+void alloc_stats_release( alloc_tag_t tag, size_t size, size_t slack )
+{
+    __atomic_sub_fetch( &stats.live_bytes, size, __ATOMIC_RELAXED );
+    __atomic_sub_fetch( &stats.slack_bytes, slack, __ATOMIC_RELAXED );
+    __atomic_add_fetch( &stats.frees, 1, __ATOMIC_RELAXED );
+    __atomic_sub_fetch( &stats.tag_live_bytes[tag], size, __ATOMIC_RELAXED );
+}
+
+void alloc_stats_get( alloc_stats_t* out )
+{
+    // Counters are read one by one, so a snapshot under load is approximate
+    uint64_t* dst = (uint64_t*)out;
+    uint64_t* src = (uint64_t*)&stats;
+    for( size_t i = 0; i < sizeof( alloc_stats_t ) / sizeof( uint64_t ); i++ )
+    {
+        dst[i] = __atomic_load_n( &src[i], __ATOMIC_RELAXED );
+    }
+}
+
+void alloc_stats_print( void )
+{
+    alloc_stats_t s;
+    alloc_stats_get( &s );
+    printf("[Alloc] live %llu B, peak %llu B, slack %llu B, %llu allocs, %llu frees\n",
+            (unsigned long long)s.live_bytes, (unsigned long long)s.peak_bytes,
+            (unsigned long long)s.slack_bytes, (unsigned long long)s.allocs, (unsigned long long)s.frees);
+    for( int t = 0; t < ALLOC_TAG_COUNT; t++ )
+    {
+        printf("[Alloc]   %-8s %llu allocs, %llu B live\n", tag_names[t],
+                (unsigned long long)s.tag_allocs[t], (unsigned long long)s.tag_live_bytes[t]);
+    }
+    printf("[Alloc] hot path allocs %llu", (unsigned long long)s.hot_path_allocs);
+    if( s.budget_bytes )
+    {
+        printf(", budget %llu B exceeded by %llu allocs", (unsigned long long)s.budget_bytes,
+                (unsigned long long)s.over_budget_allocs);
+    }
+    printf("\n");
+}
+
+void alloc_stats_set_budget( uint64_t bytes )
+{
+    __atomic_store_n( &stats.budget_bytes, bytes, __ATOMIC_RELAXED );
+}
+
+void alloc_hot_path_enter( void )
+{
+    hot_path_depth++;
+}
+
+void alloc_hot_path_exit( void )
+{
+    hot_path_depth--;
+}
+#else
+#define ALLOC_HEADER_SIZE sizeof( void* )
+#endif
+
 void* aligned_malloc( size_t size, size_t alignment )
+{
+    return aligned_malloc_tagged( size, alignment, ALLOC_TAG_OTHER );
+}
+
+void* aligned_malloc_tagged( size_t size, size_t alignment, alloc_tag_t tag )
 {
     // check if power of 2
     if( ( alignment == 0 ) || ( alignment & ( alignment - 1 )) != 0 )
@@ -10,19 +112,28 @@ void* aligned_malloc( size_t size, size_t alignment )
     }
 
     // alloc total space
-    size_t total_size = size + alignment + sizeof( void* );
+    size_t total_size = size + alignment + ALLOC_HEADER_SIZE;
     void* raw_ptr = malloc( total_size );
     if( !raw_ptr )
     {
         return NULL;
     }
     // calculate alignment
-    uintptr_t raw_addr = (uintptr_t)raw_ptr + sizeof( void* );  // round up to nearest size allocation to accomodate for original ptr
+    uintptr_t raw_addr = (uintptr_t)raw_ptr + ALLOC_HEADER_SIZE;  // round up to nearest size allocation to accomodate for original ptr
     uintptr_t aligned_addr = ( raw_addr + alignment - 1 ) & ~( alignment - 1 ); // create alignment and remove lsb
 
     // store original ptr at alignment - size(void*)
     void** stored_ptr = (void**)(aligned_addr - sizeof( void* )); // get address of space right before aligned address
     *stored_ptr = raw_ptr; // raw_ptr (original malloc of the aligned pointer) points to that address 
+#ifdef ALIGNED_MALLOC_STATS
+    alloc_header_t* header = (alloc_header_t*)( aligned_addr - ALLOC_HEADER_SIZE );
+    header->size = size;
+    header->tag = tag;
+    header->slack = (uint32_t)( total_size - size );
+    alloc_stats_record( tag, size, header->slack );
+#else
+    (void)tag;
+#endif
     // return aligned ptr
     return (void*)aligned_addr;
 }
@@ -31,6 +142,10 @@ void free_aligned( void* ptr )
     if( ptr )
     {
         void** stored_ptr = (void**)(( uintptr_t )ptr - sizeof( void* )); // pointer to address of original pointer to aligned address
+#ifdef ALIGNED_MALLOC_STATS
+        alloc_header_t* header = (alloc_header_t*)( ( uintptr_t )ptr - ALLOC_HEADER_SIZE );
+        alloc_stats_release( (alloc_tag_t)header->tag, header->size, header->slack );
+#endif
         free( *stored_ptr ); // dereference pointer to address 
     }
 }
@@ -1,14 +1,12 @@
-#include "aligned_malloc.h"
+#include "aligned_allocator.h"
 
-void* aligned_malloc( size_t size, size_t alignment )
+void* aligned_malloc_or_throw( std::size_t size, std::size_t alignment )
 {
-
-}
-void free_aligned(void* ptr)
-{
-
-}
-int is_aligned(void* ptr, size_t alignment)
-{
-    
+    // aligned_malloc(0) still returns a unique pointer, which allocate(0) needs
+    void* ptr = aligned_malloc( size, alignment );
+    if( !ptr )
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
 }
@@ -4,9 +4,65 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// What an allocation is for, so accounting can break usage down by owner
+typedef enum {
+    ALLOC_TAG_OTHER,        // Plain aligned_malloc calls
+    ALLOC_TAG_POOL,         // Slab pool reservations (frame pool)
+    ALLOC_TAG_SCRATCH,      // Per-worker arenas
+    ALLOC_TAG_CACHE,        // Metadata cache values
+    ALLOC_TAG_QUEUE,        // Frame queues and DMA rings
+    ALLOC_TAG_COUNT
+} alloc_tag_t;
 
 void* aligned_malloc( size_t size, size_t alignment );
+void* aligned_malloc_tagged( size_t size, size_t alignment, alloc_tag_t tag );
 void free_aligned(void* ptr);
 int is_aligned(void* ptr, size_t alignment);
 
-#endif
\ No newline at end of file
+// --- Allocation accounting ---
+// Built only with ALIGNED_MALLOC_STATS; otherwise every call below is an
+// empty inline and aligned_malloc keeps its single back-pointer header.
+typedef struct {
+    uint64_t live_bytes;            // Requested bytes currently allocated
+    uint64_t peak_bytes;            // High water of live_bytes
+    uint64_t slack_bytes;           // Header, alignment and rounding overhead of live allocations
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t hot_path_allocs;       // Allocations made inside alloc_hot_path_enter/exit
+    uint64_t budget_bytes;          // 0 for no budget
+    uint64_t over_budget_allocs;    // Allocations that pushed live_bytes past the budget
+    uint64_t tag_allocs[ALLOC_TAG_COUNT];
+    uint64_t tag_live_bytes[ALLOC_TAG_COUNT];
+} alloc_stats_t;
+
+#ifdef ALIGNED_MALLOC_STATS
+void alloc_stats_get( alloc_stats_t* out );
+void alloc_stats_print( void );
+void alloc_stats_set_budget( uint64_t bytes );
+// Marks the calling thread as inside the frame loop, where any allocation is a bug
+void alloc_hot_path_enter( void );
+void alloc_hot_path_exit( void );
+// For module allocators that bypass aligned_malloc (e.g. huge page mappings)
+void alloc_stats_record( alloc_tag_t tag, size_t size, size_t slack );
+void alloc_stats_release( alloc_tag_t tag, size_t size, size_t slack );
+#else
+static inline void alloc_stats_get( alloc_stats_t* out ) { memset( out, 0, sizeof( *out ) ); }
+static inline void alloc_stats_print( void ) {}
+static inline void alloc_stats_set_budget( uint64_t bytes ) { (void)bytes; }
+static inline void alloc_hot_path_enter( void ) {}
+static inline void alloc_hot_path_exit( void ) {}
+static inline void alloc_stats_record( alloc_tag_t tag, size_t size, size_t slack ) { (void)tag; (void)size; (void)slack; }
+static inline void alloc_stats_release( alloc_tag_t tag, size_t size, size_t slack ) { (void)tag; (void)size; (void)slack; }
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,59 @@
+#include "arena.h"
+#include "aligned_malloc.h"
+
+arena_t* arena_create( size_t capacity, size_t alignment )
+{
+    arena_t* arena = malloc( sizeof( arena_t ) );
+    if( !arena )
+    {
+        return NULL;
+    }
+    arena->base = aligned_malloc_tagged( capacity, alignment, ALLOC_TAG_SCRATCH );
+    if( !arena->base )
+    {
+        free( arena );
+        return NULL;
+    }
+    arena->capacity = capacity;
+    arena->offset = 0;
+    arena->high_water = 0;
+    arena->failed = 0;
+    return arena;
+}
+
+void arena_destroy( arena_t* arena )
+{
+    if( arena )
+    {
+        free_aligned( arena->base );
+        free( arena );
+    }
+}
+
+void* arena_alloc( arena_t* arena, size_t size, size_t alignment )
+{
+    if( alignment == 0 || ( alignment & ( alignment - 1 ) ) != 0 )
+    {
+        return NULL;
+    }
+    // Align the address, not the offset, so alignments above the base's still hold
+    uintptr_t current = (uintptr_t)arena->base + arena->offset;
+    uintptr_t aligned = ( current + alignment - 1 ) & ~( (uintptr_t)alignment - 1 );
+    size_t start = aligned - (uintptr_t)arena->base;
+    if( start > arena->capacity || size > arena->capacity - start )
+    {
+        arena->failed++;
+        return NULL;
+    }
+    arena->offset = start + size;
+    if( arena->offset > arena->high_water )
+    {
+        arena->high_water = arena->offset;
+    }
+    return (void*)aligned;
+}
+
+void arena_reset( arena_t* arena )
+{
+    arena->offset = 0;
+}
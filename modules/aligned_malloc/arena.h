@@ -0,0 +1,25 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator for per-frame scratch memory. Allocation moves an offset,
+// arena_reset drops everything at once, so steady state makes no allocator
+// calls. Not thread-safe: give each worker its own arena.
+typedef struct {
+    uint8_t* base;
+    size_t capacity;
+    size_t offset;
+    size_t high_water;      // Largest offset seen, for sizing the arena
+    uint32_t failed;        // Allocations that did not fit
+} arena_t;
+
+arena_t* arena_create( size_t capacity, size_t alignment );
+void arena_destroy( arena_t* arena );
+
+// NULL if the request does not fit; alignment must be a power of 2
+void* arena_alloc( arena_t* arena, size_t size, size_t alignment );
+void arena_reset( arena_t* arena );
+
+#endif
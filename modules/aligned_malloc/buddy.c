@@ -0,0 +1,271 @@
+#include "buddy.h"
+#include "aligned_malloc.h"
+
+enum { BUDDY_UNIT_INNER, BUDDY_UNIT_FREE, BUDDY_UNIT_USED };
+
+static uint32_t log2_floor( size_t value )
+{
+    uint32_t shift = 0;
+    while( ( (size_t)2 << shift ) <= value )
+    {
+        shift++;
+    }
+    return shift;
+}
+
+static void list_push( buddy_t* b, uint32_t unit, uint32_t order )
+{
+    b->order[unit] = (uint8_t)order;
+    b->state[unit] = BUDDY_UNIT_FREE;
+    b->prev[unit] = BUDDY_NONE;
+    b->next[unit] = b->free_head[order];
+    if( b->free_head[order] != BUDDY_NONE )
+    {
+        b->prev[b->free_head[order]] = unit;
+    }
+    b->free_head[order] = unit;
+}
+
+static void list_remove( buddy_t* b, uint32_t unit )
+{
+    uint32_t order = b->order[unit];
+    if( b->prev[unit] != BUDDY_NONE )
+    {
+        b->next[b->prev[unit]] = b->next[unit];
+    }
+    else
+    {
+        b->free_head[order] = b->next[unit];
+    }
+    if( b->next[unit] != BUDDY_NONE )
+    {
+        b->prev[b->next[unit]] = b->prev[unit];
+    }
+    b->state[unit] = BUDDY_UNIT_INNER;
+}
+
+buddy_t* buddy_create( size_t total_bytes, size_t min_block, uint32_t flags )
+{
+    if( min_block == 0 || ( min_block & ( min_block - 1 ) ) != 0 || total_bytes < min_block )
+    {
+        return NULL;
+    }
+    size_t units = total_bytes / min_block;
+    if( units >= BUDDY_NONE )
+    {
+        return NULL;
+    }
+    buddy_t* b = calloc( 1, sizeof( buddy_t ) );
+    if( !b )
+    {
+        return NULL;
+    }
+    if( mtx_init( &b->lock, mtx_plain ) != thrd_success )
+    {
+        free( b );
+        return NULL;
+    }
+    b->min_block = min_block;
+    b->min_shift = log2_floor( min_block );
+    b->units = (uint32_t)units;
+    b->total_bytes = units * min_block;
+    b->flags = flags;
+    b->page_mode = PAGE_MODE_NORMAL;
+
+    // Blocks are aligned to their size relative to base; align base as far as cheaply possible
+    size_t alignment = min_block < HUGE_PAGE_SIZE ? min_block : HUGE_PAGE_SIZE;
+    if( flags & BUDDY_HUGE_PAGES )
+    {
+        b->base = huge_page_alloc( b->total_bytes, &b->page_mode );
+        if( b->base )
+        {
+            alloc_stats_record( ALLOC_TAG_POOL, b->total_bytes, huge_page_round( b->total_bytes ) - b->total_bytes );
+        }
+    }
+    else
+    {
+        b->base = aligned_malloc_tagged( b->total_bytes, alignment, ALLOC_TAG_POOL );
+    }
+    b->next = malloc( units * sizeof( uint32_t ) );
+    b->prev = malloc( units * sizeof( uint32_t ) );
+    b->order = calloc( units, 1 );
+    b->state = calloc( units, 1 );
+    b->requested = calloc( units, sizeof( size_t ) );
+    if( !b->base || !b->next || !b->prev || !b->order || !b->state || !b->requested )
+    {
+        buddy_destroy( b );
+        return NULL;
+    }
+    for( uint32_t i = 0; i < BUDDY_MAX_ORDERS; i++ )
+    {
+        b->free_head[i] = BUDDY_NONE;
+    }
+
+    // Carve the range into the largest blocks that are aligned at their offset,
+    // so a budget that is not a power of 2 still loses nothing
+    uint32_t unit = 0;
+    while( unit < b->units )
+    {
+        uint32_t order = 0;
+        while( order + 1 < BUDDY_MAX_ORDERS &&
+               ( unit & ( ( 1u << ( order + 1 ) ) - 1 ) ) == 0 &&
+               unit + ( 1u << ( order + 1 ) ) <= b->units )
+        {
+            order++;
+        }
+        list_push( b, unit, order );
+        unit += 1u << order;
+    }
+    b->free_bytes = b->total_bytes;
+    return b;
+}
+
+void buddy_destroy( buddy_t* buddy )
+{
+    if( !buddy )
+    {
+        return;
+    }
+    if( buddy->base )
+    {
+        if( buddy->flags & BUDDY_HUGE_PAGES )
+        {
+            alloc_stats_release( ALLOC_TAG_POOL, buddy->total_bytes, huge_page_round( buddy->total_bytes ) - buddy->total_bytes );
+            huge_page_free( buddy->base, buddy->total_bytes );
+        }
+        else
+        {
+            free_aligned( buddy->base );
+        }
+    }
+    mtx_destroy( &buddy->lock );
+    free( buddy->next );
+    free( buddy->prev );
+    free( buddy->order );
+    free( buddy->state );
+    free( buddy->requested );
+    free( buddy );
+}
+
+void* buddy_alloc( buddy_t* buddy, size_t size )
+{
+    if( size == 0 )
+    {
+        return NULL;
+    }
+    uint32_t want = 0;
+    while( want < BUDDY_MAX_ORDERS && ( (size_t)buddy->min_block << want ) < size )
+    {
+        want++;
+    }
+
+    mtx_lock( &buddy->lock );
+    uint32_t order = want;
+    while( order < BUDDY_MAX_ORDERS && buddy->free_head[order] == BUDDY_NONE )
+    {
+        order++;
+    }
+    if( order >= BUDDY_MAX_ORDERS )
+    {
+        buddy->failed++;
+        mtx_unlock( &buddy->lock );
+        return NULL;
+    }
+    uint32_t unit = buddy->free_head[order];
+    list_remove( buddy, unit );
+    // Split down, returning the upper halves to their free lists
+    while( order > want )
+    {
+        order--;
+        list_push( buddy, unit + ( 1u << order ), order );
+    }
+    buddy->order[unit] = (uint8_t)want;
+    buddy->state[unit] = BUDDY_UNIT_USED;
+    buddy->requested[unit] = size;
+    buddy->free_bytes -= buddy->min_block << want;
+    buddy->requested_bytes += size;
+    mtx_unlock( &buddy->lock );
+    return buddy->base + ( (size_t)unit << buddy->min_shift );
+}
+
+static uint32_t unit_of( const buddy_t* buddy, const void* ptr )
+{
+    uintptr_t offset = (uintptr_t)ptr - (uintptr_t)buddy->base;
+    if( (uintptr_t)ptr < (uintptr_t)buddy->base || offset >= buddy->total_bytes ||
+        ( offset & ( buddy->min_block - 1 ) ) != 0 )
+    {
+        return BUDDY_NONE;
+    }
+    return (uint32_t)( offset >> buddy->min_shift );
+}
+
+void buddy_free( buddy_t* buddy, void* ptr )
+{
+    uint32_t unit = unit_of( buddy, ptr );
+    if( unit == BUDDY_NONE )
+    {
+        return;
+    }
+    mtx_lock( &buddy->lock );
+    if( buddy->state[unit] != BUDDY_UNIT_USED )
+    {
+        mtx_unlock( &buddy->lock );
+        return;
+    }
+    uint32_t order = buddy->order[unit];
+    buddy->state[unit] = BUDDY_UNIT_INNER;
+    buddy->free_bytes += buddy->min_block << order;
+    buddy->requested_bytes -= buddy->requested[unit];
+    buddy->requested[unit] = 0;
+
+    // Merge upwards while the buddy is a free block of the same order
+    while( order + 1 < BUDDY_MAX_ORDERS )
+    {
+        uint32_t mate = unit ^ ( 1u << order );
+        if( mate >= buddy->units || buddy->state[mate] != BUDDY_UNIT_FREE || buddy->order[mate] != order )
+        {
+            break;
+        }
+        list_remove( buddy, mate );
+        unit = unit < mate ? unit : mate;
+        order++;
+    }
+    list_push( buddy, unit, order );
+    mtx_unlock( &buddy->lock );
+}
+
+size_t buddy_block_size( buddy_t* buddy, const void* ptr )
+{
+    uint32_t unit = unit_of( buddy, ptr );
+    if( unit == BUDDY_NONE )
+    {
+        return 0;
+    }
+    mtx_lock( &buddy->lock );
+    size_t size = buddy->state[unit] == BUDDY_UNIT_USED ? buddy->min_block << buddy->order[unit] : 0;
+    mtx_unlock( &buddy->lock );
+    return size;
+}
+
+void buddy_get_stats( buddy_t* buddy, buddy_stats_t* out )
+{
+    mtx_lock( &buddy->lock );
+    out->total_bytes = buddy->total_bytes;
+    out->free_bytes = buddy->free_bytes;
+    out->largest_free = 0;
+    for( int order = BUDDY_MAX_ORDERS - 1; order >= 0; order-- )
+    {
+        if( buddy->free_head[order] != BUDDY_NONE )
+        {
+            out->largest_free = buddy->min_block << order;
+            break;
+        }
+    }
+    out->allocated_bytes = buddy->total_bytes - buddy->free_bytes;
+    out->requested_bytes = buddy->requested_bytes;
+    out->failed = buddy->failed;
+    mtx_unlock( &buddy->lock );
+
+    out->internal_frag = out->allocated_bytes ? 1.0 - (double)out->requested_bytes / out->allocated_bytes : 0.0;
+    out->external_frag = out->free_bytes ? 1.0 - (double)out->largest_free / out->free_bytes : 0.0;
+}
@@ -0,0 +1,65 @@
+#ifndef BUDDY_H
+#define BUDDY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <threads.h>
+#include "huge_page.h"
+
+#define BUDDY_MAX_ORDERS 32
+#define BUDDY_NONE       UINT32_MAX
+
+// buddy_create flags
+#define BUDDY_HUGE_PAGES 0x1    // Back the reservation with huge_page_alloc
+
+// Power-of-two block allocator over one reservation, for streams of mixed
+// frame sizes sharing a single budget. Blocks are tracked in min_block units
+// in side arrays, so free memory is never written and can stay unfaulted.
+// Freed blocks merge with their buddy whenever it is free at the same order.
+typedef struct {
+    uint8_t* base;
+    size_t total_bytes;         // Multiple of min_block
+    size_t min_block;           // Power of 2
+    uint32_t min_shift;
+    uint32_t units;             // total_bytes / min_block
+    uint32_t flags;
+    page_mode_t page_mode;
+
+    uint32_t free_head[BUDDY_MAX_ORDERS];
+    uint32_t* next;             // Free list links, per unit (head units only)
+    uint32_t* prev;
+    uint8_t* order;             // Order of the block starting at a unit
+    uint8_t* state;             // BUDDY_UNIT_* for block heads
+    size_t* requested;          // Bytes asked for, per allocated head unit
+
+    size_t free_bytes;
+    size_t requested_bytes;     // Sum of live request sizes
+    uint32_t failed;
+    mtx_t lock;
+} buddy_t;
+
+typedef struct {
+    size_t total_bytes;
+    size_t free_bytes;
+    size_t largest_free;        // Biggest single block that could be handed out
+    size_t allocated_bytes;     // Live blocks at their rounded size
+    size_t requested_bytes;     // Live blocks at their requested size
+    double internal_frag;       // 1 - requested / allocated: lost to power-of-two rounding
+    double external_frag;       // 1 - largest_free / free: free memory too scattered to use
+    uint32_t failed;
+} buddy_stats_t;
+
+// total_bytes is rounded down to whole min_blocks; min_block must be a power of 2
+buddy_t* buddy_create( size_t total_bytes, size_t min_block, uint32_t flags );
+void buddy_destroy( buddy_t* buddy );
+
+// Smallest block that holds size, aligned to its own size relative to base
+void* buddy_alloc( buddy_t* buddy, size_t size );
+void buddy_free( buddy_t* buddy, void* ptr );
+
+// Rounded size of the live block at ptr, 0 if ptr is not a live block
+size_t buddy_block_size( buddy_t* buddy, const void* ptr );
+void buddy_get_stats( buddy_t* buddy, buddy_stats_t* out );
+
+#endif
@@ -0,0 +1,141 @@
+#define _GNU_SOURCE
+#include "huge_page.h"
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+size_t huge_page_round( size_t size )
+{
+    return ( size + HUGE_PAGE_SIZE - 1 ) & ~( (size_t)HUGE_PAGE_SIZE - 1 );
+}
+
+// THP 'never' accepts MADV_HUGEPAGE but never backs anything with it
+static int thp_disabled( void )
+{
+    FILE* f = fopen( "/sys/kernel/mm/transparent_hugepage/enabled", "r" );
+    if( !f )
+    {
+        return 1;
+    }
+    char policy[64] = { 0 };
+    size_t n = fread( policy, 1, sizeof( policy ) - 1, f );
+    fclose( f );
+    policy[n] = '\0';
+    return strstr( policy, "[never]" ) != NULL;
+}
+
+// AnonHugePages of the /proc/self/smaps entry containing addr, in KB; 0 when
+// it cannot be read. Neighbouring anonymous mappings may have merged into the
+// same entry, but a freshly faulted 2 MB aligned range dominates it.
+static uint64_t anon_huge_kb( const void* addr )
+{
+    FILE* f = fopen( "/proc/self/smaps", "r" );
+    if( !f )
+    {
+        return 0;
+    }
+    char line[256];
+    int inside = 0;
+    uint64_t kb = 0;
+    while( fgets( line, sizeof( line ), f ) )
+    {
+        uintptr_t start, end;
+        if( sscanf( line, "%" SCNxPTR "-%" SCNxPTR " ", &start, &end ) == 2 )
+        {
+            if( inside )
+            {
+                break;
+            }
+            inside = (uintptr_t)addr >= start && (uintptr_t)addr < end;
+        }
+        else if( inside && sscanf( line, "AnonHugePages: %" SCNu64 " kB", &kb ) == 1 )
+        {
+            break;
+        }
+    }
+    fclose( f );
+    return kb;
+}
+
+void* huge_page_alloc( size_t size, page_mode_t* mode )
+{
+    if( size == 0 )
+    {
+        return NULL;
+    }
+    size_t length = huge_page_round( size );
+
+#ifdef MAP_HUGETLB
+    // Needs pages reserved in /proc/sys/vm/nr_hugepages, fails cleanly otherwise
+    void* ptr = mmap( NULL, length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+    if( ptr != MAP_FAILED )
+    {
+        if( mode ) *mode = PAGE_MODE_HUGETLB;
+        return ptr;
+    }
+#endif
+
+    // Over-map by one huge page and trim, so the range starts on a 2 MB
+    // boundary and every 2 MB of it is eligible for a huge page
+    uint8_t* raw = mmap( NULL, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( raw == MAP_FAILED )
+    {
+        return NULL;
+    }
+    uint8_t* aligned = (uint8_t*)( ( (uintptr_t)raw + HUGE_PAGE_SIZE - 1 ) & ~( (uintptr_t)HUGE_PAGE_SIZE - 1 ) );
+    size_t head = aligned - raw;
+    size_t tail = HUGE_PAGE_SIZE - head;
+    if( head )
+    {
+        munmap( raw, head );
+    }
+    if( tail )
+    {
+        munmap( aligned + length, tail );
+    }
+
+    page_mode_t obtained = PAGE_MODE_NORMAL;
+#ifdef MADV_HUGEPAGE
+    // Only requested here: nothing is faulted, so the caller can still bind
+    // the range to a NUMA node first. huge_page_verify confirms it later.
+    if( !thp_disabled() && madvise( aligned, length, MADV_HUGEPAGE ) == 0 )
+    {
+        obtained = PAGE_MODE_THP;
+    }
+#endif
+    if( mode ) *mode = obtained;
+    return aligned;
+}
+
+page_mode_t huge_page_verify( const void* ptr, page_mode_t mode )
+{
+    // madvise only asks; with defrag off or fragmented memory the kernel
+    // still faults in 4 KB pages
+    if( mode == PAGE_MODE_THP && anon_huge_kb( ptr ) == 0 )
+    {
+        return PAGE_MODE_NORMAL;
+    }
+    return mode;
+}
+
+void huge_page_free( void* ptr, size_t size )
+{
+    if( ptr )
+    {
+        munmap( ptr, huge_page_round( size ) );
+    }
+}
+
+const char* page_mode_name( page_mode_t mode )
+{
+    switch( mode )
+    {
+        case PAGE_MODE_HUGETLB: return "hugetlb 2MB";
+        case PAGE_MODE_THP:     return "transparent huge pages";
+        default:                return "4KB pages";
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef HUGE_PAGE_H
+#define HUGE_PAGE_H
+
+#include <stddef.h>
+
+#define HUGE_PAGE_SIZE ( 2u * 1024 * 1024 )
+
+// Backing actually obtained for a huge_page_alloc mapping, best first
+typedef enum {
+    PAGE_MODE_HUGETLB,  // Explicit MAP_HUGETLB, reserved 2 MB pages
+    PAGE_MODE_THP,      // MADV_HUGEPAGE accepted; confirmed by huge_page_verify once faulted
+    PAGE_MODE_NORMAL    // 4 KB pages
+} page_mode_t;
+
+// Maps size rounded up to HUGE_PAGE_SIZE, 2 MB aligned, trying MAP_HUGETLB,
+// then transparent huge pages, then normal pages. mode (may be NULL) reports
+// which one succeeded. Memory is zeroed. Release with huge_page_free.
+void* huge_page_alloc( size_t size, page_mode_t* mode );
+// Backing actually behind ptr once its first huge page has been faulted:
+// PAGE_MODE_THP becomes PAGE_MODE_NORMAL unless smaps shows huge pages there.
+// Other modes are returned unchanged.
+page_mode_t huge_page_verify( const void* ptr, page_mode_t mode );
+void huge_page_free( void* ptr, size_t size );
+const char* page_mode_name( page_mode_t mode );
+// Bytes a huge_page_alloc of 'size' actually maps
+size_t huge_page_round( size_t size );
+
+#endif
@@ -0,0 +1,336 @@
+#include "aligned_malloc.h"
+#include "slab_pool.h"
+#include "arena.h"
+#include "buddy.h"
+#include <stdio.h>
+#include <assert.h>
+#include <threads.h>
+
+// Test counter
+uint32_t test_count = 0;
+uint32_t passed_count = 0;
+
+void test_header(const char* name) {
+    printf("\n========================================\n");
+    printf("Test %d: %s\n", ++test_count, name);
+    printf("========================================\n");
+}
+
+void test_pass(const char* msg) {
+    printf("PASS: %s\n", msg);
+    passed_count++;
+}
+
+// Test 1: aligned_malloc honours the alignment
+void test_aligned_malloc() {
+    test_header("Aligned Malloc");
+
+    void* ptr = aligned_malloc(100, 64);
+    assert(ptr != NULL);
+    assert(is_aligned(ptr, 64));
+    free_aligned(ptr);
+    assert(aligned_malloc(100, 48) == NULL);
+    test_pass("64-byte aligned, non power of 2 rejected");
+}
+
+// Test 2: Slots are aligned, distinct, and exhaust at slot_count
+void test_slab_exhaustion() {
+    test_header("Slab Pool Exhaustion");
+
+    slab_pool_t* pool = slab_pool_create(100, 4, 64, 0);
+    assert(pool != NULL);
+    assert(pool->slot_size == 128);
+
+    void* slots[4];
+    for (int i = 0; i < 4; i++) {
+        slots[i] = slab_alloc(pool);
+        assert(slots[i] != NULL);
+        assert(is_aligned(slots[i], 64));
+        for (int j = 0; j < i; j++) {
+            assert(slots[i] != slots[j]);
+        }
+    }
+    assert(slab_alloc(pool) == NULL);
+    test_pass("4 aligned distinct slots, 5th alloc fails");
+
+    slab_free(pool, slots[2]);
+    assert(slab_alloc(pool) == slots[2]);
+    test_pass("Freed slot is reused");
+
+    slab_pool_destroy(pool);
+}
+
+// Test 3: Ownership query maps interior pointers back to their slot
+void test_slab_index_of() {
+    test_header("Slab Pool Index Of");
+
+    slab_pool_t* pool = slab_pool_create(256, 3, 64, 0);
+    uint8_t* slot = slab_slot(pool, 1);
+    assert(slab_index_of(pool, slot) == 1);
+    assert(slab_index_of(pool, slot + 255) == 1);
+    assert(slab_index_of(pool, slot + 256) == 2);
+    assert(slab_index_of(pool, pool->base - 1) == SLAB_NONE);
+    assert(slab_index_of(pool, pool->base + 3 * 256) == SLAB_NONE);
+    test_pass("Interior pointers resolve, out of range is SLAB_NONE");
+
+    slab_pool_destroy(pool);
+}
+
+// Test 4: Magazine serves frees back without the shared list
+void test_slab_magazine() {
+    test_header("Slab Pool Magazine");
+
+    slab_pool_t* pool = slab_pool_create(64, 8, 64, 0);
+    slab_magazine_t mag = { 0 };
+    void* slots[8];
+    for (int i = 0; i < 8; i++) {
+        slots[i] = slab_magazine_alloc(pool, &mag);
+        assert(slots[i] != NULL);
+    }
+    for (int i = 0; i < 8; i++) {
+        slab_magazine_free(pool, &mag, slots[i]);
+    }
+    assert(mag.count <= SLAB_MAGAZINE_SIZE);
+    assert(slab_magazine_alloc(pool, &mag) == slots[7]);
+    test_pass("Magazine bounded, most recent free returned first");
+
+    slab_magazine_free(pool, &mag, slots[7]);
+    slab_magazine_drain(pool, &mag);
+    assert(mag.count == 0);
+    int available = 0;
+    while (slab_alloc(pool)) {
+        available++;
+    }
+    assert(available == 8);
+    test_pass("Drain returns every slot to the pool");
+
+    slab_pool_destroy(pool);
+}
+
+#define STRESS_THREADS 4
+#define STRESS_ROUNDS  100000
+
+static int stress_worker(void* arg) {
+    slab_pool_t* pool = arg;
+    for (int i = 0; i < STRESS_ROUNDS; i++) {
+        uint32_t* a = slab_alloc(pool);
+        uint32_t* b = slab_alloc(pool);
+        // Each slot is exclusively ours while held
+        if (a) { *a = i; }
+        if (b) { *b = i; }
+        if (a) { assert(*a == (uint32_t)i); slab_free(pool, a); }
+        if (b) { assert(*b == (uint32_t)i); slab_free(pool, b); }
+    }
+    return 0;
+}
+
+// Test 5: Concurrent alloc/free never hands out a slot twice or loses one
+void test_slab_concurrent() {
+    test_header("Slab Pool Concurrent Alloc/Free");
+
+    slab_pool_t* pool = slab_pool_create(64, 6, 64, 0);
+    thrd_t threads[STRESS_THREADS];
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        thrd_create(&threads[i], stress_worker, pool);
+    }
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        thrd_join(threads[i], NULL);
+    }
+    int available = 0;
+    while (slab_alloc(pool)) {
+        available++;
+    }
+    assert(available == 6);
+    test_pass("All slots accounted for after contention");
+
+    slab_pool_destroy(pool);
+}
+
+// Test 6: Huge page backed pool is 2 MB aligned whatever backing it got
+void test_slab_huge_pages() {
+    test_header("Slab Pool Huge Pages");
+
+    slab_pool_t* pool = slab_pool_create(3 * 1024 * 1024, 2, 64, SLAB_POOL_HUGE_PAGES);
+    assert(pool != NULL);
+    assert(is_aligned(pool->base, HUGE_PAGE_SIZE));
+    uint8_t* last = slab_slot(pool, 1);
+    last[pool->slot_size - 1] = 1;
+    slab_pool_prefault(pool, 1, false);
+    printf("Obtained: %s\n", page_mode_name(pool->page_mode));
+    test_pass("Reservation 2 MB aligned and writable to the end");
+
+    slab_pool_destroy(pool);
+}
+
+// Test 7: Arena bump allocation honours alignment and capacity
+void test_arena_alloc() {
+    test_header("Arena Alloc");
+
+    arena_t* arena = arena_create(256, 64);
+    assert(arena != NULL);
+    uint8_t* a = arena_alloc(arena, 10, 1);
+    uint8_t* b = arena_alloc(arena, 32, 32);
+    assert(a == arena->base);
+    assert(is_aligned(b, 32) && b >= a + 10);
+    test_pass("Allocations are packed and aligned");
+
+    assert(arena_alloc(arena, 256, 1) == NULL);
+    assert(arena->failed == 1);
+    assert(arena_alloc(arena, 256 - arena->offset, 1) != NULL);
+    assert(arena->offset == 256);
+    test_pass("Overflow fails cleanly, exact fit succeeds");
+
+    arena_destroy(arena);
+}
+
+// Test 8: Reset rewinds in O(1) and keeps the high water mark
+void test_arena_reset() {
+    test_header("Arena Reset");
+
+    arena_t* arena = arena_create(1024, 64);
+    void* first = arena_alloc(arena, 100, 16);
+    arena_alloc(arena, 400, 16);
+    size_t peak = arena->offset;
+    arena_reset(arena);
+    assert(arena->offset == 0);
+    assert(arena->high_water == peak);
+    assert(arena_alloc(arena, 100, 16) == first);
+    test_pass("Reset reuses the same memory, high water retained");
+
+    arena_destroy(arena);
+}
+
+// Test 9: Prefault leaves contents intact and covers every slot
+void test_slab_prefault() {
+    test_header("Slab Pool Prefault");
+
+    slab_pool_t* pool = slab_pool_create(1000 * 1000, 3, 64, 0);
+    uint8_t* slot = slab_slot(pool, 2);
+    slot[12345] = 0xA5;
+    slab_pool_prefault(pool, 4, true);
+    assert(slot[12345] == 0xA5);
+    printf("mlock %s\n", pool->locked ? "succeeded" : "refused (RLIMIT_MEMLOCK)");
+    test_pass("Prefault across 4 threads preserves data");
+
+    slab_pool_destroy(pool);
+}
+
+#define MB (1024 * 1024)
+
+// Test 10: 4K, 1080p and VGA frames share one budget and coalesce back
+void test_buddy_mixed_resolutions() {
+    test_header("Buddy Mixed Resolutions");
+
+    // 48 MB is not a power of 2: carved as a 32 MB and a 16 MB block
+    buddy_t* buddy = buddy_create(48 * MB, 256 * 1024, 0);
+    assert(buddy != NULL);
+    void* still = buddy_alloc(buddy, 3840 * 2160 * 3);     // 24.9 MB -> 32 MB
+    void* video = buddy_alloc(buddy, 1920 * 1080 * 3);     // 6.2 MB  -> 8 MB
+    void* preview[4];
+    for (int i = 0; i < 4; i++) {
+        preview[i] = buddy_alloc(buddy, 640 * 480 * 3);    // 0.9 MB  -> 1 MB
+        assert(preview[i] != NULL);
+        assert(is_aligned(preview[i], 256 * 1024));
+    }
+    assert(still && video);
+    assert(buddy_block_size(buddy, still) == 32 * MB);
+    assert(buddy_block_size(buddy, video) == 8 * MB);
+    assert(buddy_alloc(buddy, 8 * MB) == NULL);
+    test_pass("One 4K still, one 1080p and four VGA frames fit in 48 MB");
+
+    buddy_free(buddy, video);
+    for (int i = 0; i < 4; i++) {
+        buddy_free(buddy, preview[i]);
+    }
+    buddy_stats_t stats;
+    buddy_get_stats(buddy, &stats);
+    assert(stats.largest_free == 16 * MB);
+    buddy_free(buddy, still);
+    buddy_get_stats(buddy, &stats);
+    assert(stats.free_bytes == 48 * MB && stats.largest_free == 32 * MB);
+    test_pass("Freed blocks coalesce back to the initial carving");
+
+    buddy_destroy(buddy);
+}
+
+// Test 11: Fragmentation is reported for rounding and for scattered holes
+void test_buddy_fragmentation() {
+    test_header("Buddy Fragmentation");
+
+    buddy_t* buddy = buddy_create(16 * MB, MB, 0);
+    void* blocks[16];
+    for (int i = 0; i < 16; i++) {
+        blocks[i] = buddy_alloc(buddy, 768 * 1024);
+    }
+    buddy_stats_t stats;
+    buddy_get_stats(buddy, &stats);
+    assert(stats.free_bytes == 0);
+    assert(stats.internal_frag > 0.24 && stats.internal_frag < 0.26);
+    test_pass("Internal fragmentation 25% for 768 KB in 1 MB blocks");
+
+    // Free every other block: 8 MB free, none of it adjacent
+    for (int i = 0; i < 16; i += 2) {
+        buddy_free(buddy, blocks[i]);
+    }
+    buddy_get_stats(buddy, &stats);
+    assert(stats.free_bytes == 8 * MB && stats.largest_free == MB);
+    assert(stats.external_frag > 0.87);
+    assert(buddy_alloc(buddy, 2 * MB) == NULL);
+    test_pass("External fragmentation reported, 2 MB request fails");
+
+    buddy_free(buddy, blocks[1]);
+    assert(buddy_alloc(buddy, 4 * MB) == NULL);
+    buddy_free(buddy, blocks[3]);
+    assert(buddy_alloc(buddy, 4 * MB) == blocks[0]);
+    test_pass("Neighbours merge once both buddies are free");
+
+    buddy_destroy(buddy);
+}
+
+#ifdef ALIGNED_MALLOC_STATS
+// Test 12: Accounting tracks live, peak, tags and hot-path allocations
+void test_alloc_stats() {
+    test_header("Allocation Accounting");
+
+    alloc_stats_t before, after;
+    alloc_stats_get(&before);
+    void* a = aligned_malloc_tagged(1000, 64, ALLOC_TAG_CACHE);
+    alloc_hot_path_enter();
+    void* b = aligned_malloc(24, 16);
+    alloc_hot_path_exit();
+    alloc_stats_get(&after);
+    assert(after.live_bytes - before.live_bytes == 1024);
+    assert(after.peak_bytes >= after.live_bytes);
+    assert(after.tag_allocs[ALLOC_TAG_CACHE] - before.tag_allocs[ALLOC_TAG_CACHE] == 1);
+    assert(after.hot_path_allocs - before.hot_path_allocs == 1);
+    assert(after.slack_bytes > before.slack_bytes);
+    test_pass("Live bytes, tag and hot-path counts recorded");
+
+    free_aligned(a);
+    free_aligned(b);
+    alloc_stats_get(&after);
+    assert(after.live_bytes == before.live_bytes);
+    assert(after.slack_bytes == before.slack_bytes);
+    test_pass("Frees return live and slack to where they were");
+}
+#endif
+
+int main() {
+    test_aligned_malloc();
+    test_slab_exhaustion();
+    test_slab_index_of();
+    test_slab_magazine();
+    test_slab_concurrent();
+    test_slab_huge_pages();
+    test_arena_alloc();
+    test_arena_reset();
+    test_slab_prefault();
+    test_buddy_mixed_resolutions();
+    test_buddy_fragmentation();
+#ifdef ALIGNED_MALLOC_STATS
+    test_alloc_stats();
+#endif
+
+    printf("\n%u tests, %u checks passed\n", test_count, passed_count);
+    return 0;
+}
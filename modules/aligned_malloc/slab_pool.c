@@ -0,0 +1,289 @@
+#define _GNU_SOURCE
+#include "slab_pool.h"
+#include "aligned_malloc.h"
+#include <sys/mman.h>
+#include <threads.h>
+#include <unistd.h>
+
+#define PREFAULT_MAX_THREADS 16
+
+static inline uint64_t pack_head( uint32_t tag, uint32_t index )
+{
+    return ( (uint64_t)tag << 32 ) | index;
+}
+
+slab_pool_t* slab_pool_create( size_t slot_size, uint32_t slot_count, size_t alignment, uint32_t flags )
+{
+    if( slot_size == 0 || slot_count == 0 || slot_count == SLAB_NONE ||
+        alignment == 0 || ( alignment & ( alignment - 1 ) ) != 0 )
+    {
+        return NULL;
+    }
+    slab_pool_t* pool = malloc( sizeof( slab_pool_t ) );
+    if( !pool )
+    {
+        return NULL;
+    }
+    // Round each slot up so every slot, not just the first, is aligned
+    pool->slot_size = ( slot_size + alignment - 1 ) & ~( alignment - 1 );
+    pool->slot_count = slot_count;
+    pool->flags = flags;
+    pool->page_mode = PAGE_MODE_NORMAL;
+    pool->locked = false;
+    // Huge page mappings are 2 MB aligned, which covers any slot alignment up to that
+    if( ( flags & SLAB_POOL_HUGE_PAGES ) && alignment <= HUGE_PAGE_SIZE )
+    {
+        size_t bytes = pool->slot_size * slot_count;
+        pool->base = huge_page_alloc( bytes, &pool->page_mode );
+        if( pool->base )
+        {
+            alloc_stats_record( ALLOC_TAG_POOL, bytes, huge_page_round( bytes ) - bytes );
+        }
+    }
+    else
+    {
+        pool->flags &= ~SLAB_POOL_HUGE_PAGES;
+        pool->base = aligned_malloc_tagged( pool->slot_size * slot_count, alignment, ALLOC_TAG_POOL );
+    }
+    pool->next_free = malloc( slot_count * sizeof( uint32_t ) );
+    if( !pool->base || !pool->next_free )
+    {
+        slab_pool_destroy( pool );
+        return NULL;
+    }
+    for( uint32_t i = 0; i < slot_count; i++ )
+    {
+        pool->next_free[i] = ( i + 1 < slot_count ) ? i + 1 : SLAB_NONE;
+    }
+    pool->free_head = pack_head( 0, 0 );
+    return pool;
+}
+
+void slab_pool_destroy( slab_pool_t* pool )
+{
+    if( !pool )
+    {
+        return;
+    }
+    if( pool->locked )
+    {
+        munlock( pool->base, pool->slot_size * pool->slot_count );
+    }
+    if( pool->flags & SLAB_POOL_HUGE_PAGES )
+    {
+        size_t bytes = pool->slot_size * pool->slot_count;
+        if( pool->base )
+        {
+            alloc_stats_release( ALLOC_TAG_POOL, bytes, huge_page_round( bytes ) - bytes );
+        }
+        huge_page_free( pool->base, bytes );
+    }
+    else
+    {
+        free_aligned( pool->base );
+    }
+    free( pool->next_free );
+    free( pool );
+}
+
+typedef struct {
+    uint8_t* start;
+    size_t length;
+} prefault_range_t;
+
+static int prefault_worker( void* arg )
+{
+    prefault_range_t* range = arg;
+    size_t page = (size_t)sysconf( _SC_PAGESIZE );
+    // The first range starts at base, which need not be page aligned; the
+    // page it lies in is ours, so walk whole pages from there
+    uintptr_t start = (uintptr_t)range->start;
+    uintptr_t end = start + range->length;
+    uintptr_t first = start & ~( page - 1 );
+#ifdef MADV_POPULATE_WRITE
+    // One call faults the whole range in-kernel, no per-page trap
+    if( madvise( (void*)first, end - first, MADV_POPULATE_WRITE ) == 0 )
+    {
+        return 0;
+    }
+#endif
+    // Write the existing byte back: faults the page writable without changing it
+    for( uintptr_t addr = first; addr < end; addr += page )
+    {
+        volatile uint8_t* p = (uint8_t*)( addr < start ? start : addr );
+        *p = *p;
+    }
+    return 0;
+}
+
+void slab_pool_prefault( slab_pool_t* pool, uint32_t threads, bool lock )
+{
+    size_t total = pool->slot_size * pool->slot_count;
+    size_t page = (size_t)sysconf( _SC_PAGESIZE );
+    if( threads == 0 )
+    {
+        threads = 1;
+    }
+    if( threads > PREFAULT_MAX_THREADS )
+    {
+        threads = PREFAULT_MAX_THREADS;
+    }
+
+    // Page-aligned chunks so no two workers fault the same page
+    uintptr_t begin = (uintptr_t)pool->base & ~( page - 1 );
+    uintptr_t end = (uintptr_t)pool->base + total;
+    size_t pages = ( end - begin + page - 1 ) / page;
+    size_t chunk = ( ( pages + threads - 1 ) / threads ) * page;
+
+    thrd_t workers[PREFAULT_MAX_THREADS];
+    prefault_range_t ranges[PREFAULT_MAX_THREADS];
+    uint32_t started = 0;
+    for( uint32_t i = 0; i < threads; i++ )
+    {
+        uintptr_t lo = begin + i * chunk;
+        if( lo >= end )
+        {
+            break;
+        }
+        uintptr_t hi = ( lo + chunk < end ) ? lo + chunk : end;
+        // The first page may start before base; touch from base onwards only
+        ranges[i].start = (uint8_t*)( lo < (uintptr_t)pool->base ? (uintptr_t)pool->base : lo );
+        ranges[i].length = hi - (uintptr_t)ranges[i].start;
+        if( i == 0 )
+        {
+            continue;   // Calling thread takes the first chunk
+        }
+        if( thrd_create( &workers[i], prefault_worker, &ranges[i] ) != thrd_success )
+        {
+            prefault_worker( &ranges[i] );
+        }
+        else
+        {
+            started |= 1u << i;
+        }
+    }
+    prefault_worker( &ranges[0] );
+    for( uint32_t i = 1; i < threads; i++ )
+    {
+        if( started & ( 1u << i ) )
+        {
+            thrd_join( workers[i], NULL );
+        }
+    }
+
+    if( lock && !pool->locked )
+    {
+        pool->locked = mlock( pool->base, total ) == 0;
+    }
+    // Faulted now, so smaps can tell whether THP actually took
+    pool->page_mode = huge_page_verify( pool->base, pool->page_mode );
+}
+
+static uint32_t pop_index( slab_pool_t* pool )
+{
+    uint64_t head = __atomic_load_n( &pool->free_head, __ATOMIC_ACQUIRE );
+    for( ;; )
+    {
+        uint32_t index = (uint32_t)head;
+        if( index == SLAB_NONE )
+        {
+            return SLAB_NONE;
+        }
+        // May read a stale link if another thread popped 'index' meanwhile;
+        // the tag then differs and the CAS below fails
+        uint32_t next = __atomic_load_n( &pool->next_free[index], __ATOMIC_RELAXED );
+        uint64_t desired = pack_head( (uint32_t)( head >> 32 ) + 1, next );
+        if( __atomic_compare_exchange_n( &pool->free_head, &head, desired, true,
+                                         __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE ) )
+        {
+            return index;
+        }
+    }
+}
+
+static void push_index( slab_pool_t* pool, uint32_t index )
+{
+    uint64_t head = __atomic_load_n( &pool->free_head, __ATOMIC_RELAXED );
+    for( ;; )
+    {
+        __atomic_store_n( &pool->next_free[index], (uint32_t)head, __ATOMIC_RELAXED );
+        uint64_t desired = pack_head( (uint32_t)( head >> 32 ) + 1, index );
+        if( __atomic_compare_exchange_n( &pool->free_head, &head, desired, true,
+                                         __ATOMIC_RELEASE, __ATOMIC_RELAXED ) )
+        {
+            return;
+        }
+    }
+}
+
+void* slab_alloc( slab_pool_t* pool )
+{
+    uint32_t index = pop_index( pool );
+    return index == SLAB_NONE ? NULL : pool->base + (size_t)index * pool->slot_size;
+}
+
+void slab_free( slab_pool_t* pool, void* ptr )
+{
+    uint32_t index = slab_index_of( pool, ptr );
+    if( index != SLAB_NONE )
+    {
+        push_index( pool, index );
+    }
+}
+
+void* slab_magazine_alloc( slab_pool_t* pool, slab_magazine_t* mag )
+{
+    if( mag->count > 0 )
+    {
+        return pool->base + (size_t)mag->slots[--mag->count] * pool->slot_size;
+    }
+    return slab_alloc( pool );
+}
+
+void slab_magazine_free( slab_pool_t* pool, slab_magazine_t* mag, void* ptr )
+{
+    uint32_t index = slab_index_of( pool, ptr );
+    if( index == SLAB_NONE )
+    {
+        return;
+    }
+    if( mag->count == SLAB_MAGAZINE_SIZE )
+    {
+        // Full: hand the oldest half back so a steady free/alloc pattern
+        // around the boundary does not bounce on the shared list
+        for( uint32_t i = 0; i < SLAB_MAGAZINE_SIZE / 2; i++ )
+        {
+            push_index( pool, mag->slots[i] );
+        }
+        for( uint32_t i = SLAB_MAGAZINE_SIZE / 2; i < SLAB_MAGAZINE_SIZE; i++ )
+        {
+            mag->slots[i - SLAB_MAGAZINE_SIZE / 2] = mag->slots[i];
+        }
+        mag->count -= SLAB_MAGAZINE_SIZE / 2;
+    }
+    mag->slots[mag->count++] = index;
+}
+
+void slab_magazine_drain( slab_pool_t* pool, slab_magazine_t* mag )
+{
+    while( mag->count > 0 )
+    {
+        push_index( pool, mag->slots[--mag->count] );
+    }
+}
+
+uint32_t slab_index_of( const slab_pool_t* pool, const void* ptr )
+{
+    uintptr_t addr = (uintptr_t)ptr;
+    uintptr_t base = (uintptr_t)pool->base;
+    if( addr < base || addr >= base + pool->slot_size * pool->slot_count )
+    {
+        return SLAB_NONE;
+    }
+    return (uint32_t)( ( addr - base ) / pool->slot_size );
+}
+
+void* slab_slot( const slab_pool_t* pool, uint32_t index )
+{
+    return index < pool->slot_count ? pool->base + (size_t)index * pool->slot_size : NULL;
+}
@@ -0,0 +1,56 @@
+#ifndef SLAB_POOL_H
+#define SLAB_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "huge_page.h"
+
+#define SLAB_MAGAZINE_SIZE 4
+#define SLAB_NONE          UINT32_MAX
+
+// slab_pool_create flags
+#define SLAB_POOL_HUGE_PAGES  0x1   // Back the reservation with 2 MB pages when possible
+
+// N equally sized, aligned slots carved from one contiguous reservation.
+// Free slots form a LIFO list of indices; the head packs a tag in the upper
+// 32 bits so a pop racing with pop/push/pop of the same slot (ABA) fails its CAS.
+typedef struct {
+    uint8_t* base;          // First slot, aligned
+    size_t slot_size;       // Requested size rounded up to the alignment
+    uint32_t slot_count;
+    uint32_t* next_free;    // Next index in the free list, per slot
+    uint64_t free_head;     // (tag << 32) | index, accessed atomically
+    uint32_t flags;
+    page_mode_t page_mode;  // Backing obtained for the reservation; THP is confirmed by slab_pool_prefault
+    bool locked;            // Reservation pinned in RAM by slab_pool_prefault
+} slab_pool_t;
+
+// Per-thread cache of free slots. Owned by one thread, so no atomics: frees
+// and allocs that hit the magazine never touch the shared free list.
+typedef struct {
+    uint32_t count;
+    uint32_t slots[SLAB_MAGAZINE_SIZE];
+} slab_magazine_t;
+
+slab_pool_t* slab_pool_create( size_t slot_size, uint32_t slot_count, size_t alignment, uint32_t flags );
+void slab_pool_destroy( slab_pool_t* pool );
+
+// Faults in every page of the reservation, split across 'threads' threads,
+// so the first pass over a slot takes no page faults. With 'lock' the pages
+// are also mlocked; pool->locked reports whether that succeeded (it needs
+// RLIMIT_MEMLOCK headroom). Chunks whose thread cannot start run inline.
+void slab_pool_prefault( slab_pool_t* pool, uint32_t threads, bool lock );
+
+void* slab_alloc( slab_pool_t* pool );
+void slab_free( slab_pool_t* pool, void* ptr );
+
+void* slab_magazine_alloc( slab_pool_t* pool, slab_magazine_t* mag );
+void slab_magazine_free( slab_pool_t* pool, slab_magazine_t* mag, void* ptr );
+void slab_magazine_drain( slab_pool_t* pool, slab_magazine_t* mag );
+
+// Slot index owning ptr (any address inside the slot), or SLAB_NONE
+uint32_t slab_index_of( const slab_pool_t* pool, const void* ptr );
+void* slab_slot( const slab_pool_t* pool, uint32_t index );
+
+#endif
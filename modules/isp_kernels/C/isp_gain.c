@@ -0,0 +1,190 @@
+#include "isp_gain.h"
+
+#ifdef ISP_X86
+#include <immintrin.h>
+#endif
+
+// --- Scalar ---
+
+void gain_apply_reference( uint8_t* data, size_t n, float gain )
+{
+    for( size_t i = 0; i < n; i++ )
+    {
+        data[i] = (uint8_t)( data[i] * gain > 255 ? 255 : data[i] * gain );
+    }
+}
+
+static void gain_fixed_scalar( uint8_t* data, size_t n, uint16_t gain_q8 )
+{
+    for( size_t i = 0; i < n; i++ )
+    {
+        uint32_t value = ( data[i] * (uint32_t)gain_q8 ) >> 8;
+        data[i] = (uint8_t)( value > 255 ? 255 : value );
+    }
+}
+
+#ifdef ISP_X86
+
+// --- SSE2 ---
+
+__attribute__(( target( "sse2" ) ))
+static void gain_float_sse2( uint8_t* data, size_t n, float gain )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 g = _mm_set1_ps( gain );
+    size_t i = 0;
+    for( ; i + 16 <= n; i += 16 )
+    {
+        __m128i px = _mm_loadu_si128( (const __m128i*)( data + i ) );
+        __m128i lo16 = _mm_unpacklo_epi8( px, zero );
+        __m128i hi16 = _mm_unpackhi_epi8( px, zero );
+        __m128i q[4] = { _mm_unpacklo_epi16( lo16, zero ), _mm_unpackhi_epi16( lo16, zero ),
+                         _mm_unpacklo_epi16( hi16, zero ), _mm_unpackhi_epi16( hi16, zero ) };
+        for( int k = 0; k < 4; k++ )
+        {
+            // Truncate like the scalar cast; packs/packus below do the clamp
+            q[k] = _mm_cvttps_epi32( _mm_mul_ps( _mm_cvtepi32_ps( q[k] ), g ) );
+        }
+        __m128i out = _mm_packus_epi16( _mm_packs_epi32( q[0], q[1] ), _mm_packs_epi32( q[2], q[3] ) );
+        _mm_storeu_si128( (__m128i*)( data + i ), out );
+    }
+    gain_apply_reference( data + i, n - i, gain );
+}
+
+__attribute__(( target( "sse2" ) ))
+static void gain_fixed_sse2( uint8_t* data, size_t n, uint16_t gain_q8 )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i g = _mm_set1_epi16( (short)gain_q8 );
+    const __m128i max = _mm_set1_epi16( 255 );
+    size_t i = 0;
+    for( ; i + 16 <= n; i += 16 )
+    {
+        __m128i px = _mm_loadu_si128( (const __m128i*)( data + i ) );
+        // Bytes into the high half of 16-bit lanes: mulhi( x << 8, g ) = ( x * g ) >> 8
+        __m128i lo = _mm_mulhi_epu16( _mm_unpacklo_epi8( zero, px ), g );
+        __m128i hi = _mm_mulhi_epu16( _mm_unpackhi_epi8( zero, px ), g );
+        // min( v, 255 ) without SSE4.1: packus saturates signed, so clamp first
+        lo = _mm_sub_epi16( lo, _mm_subs_epu16( lo, max ) );
+        hi = _mm_sub_epi16( hi, _mm_subs_epu16( hi, max ) );
+        _mm_storeu_si128( (__m128i*)( data + i ), _mm_packus_epi16( lo, hi ) );
+    }
+    gain_fixed_scalar( data + i, n - i, gain_q8 );
+}
+
+// --- AVX2 ---
+
+__attribute__(( target( "avx2" ) ))
+static void gain_float_avx2( uint8_t* data, size_t n, float gain )
+{
+    const __m256 g = _mm256_set1_ps( gain );
+    // packs/packus interleave the two 128-bit lanes; this puts the dwords back in order
+    const __m256i order = _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 );
+    size_t i = 0;
+    for( ; i + 32 <= n; i += 32 )
+    {
+        __m256i q[4];
+        for( int k = 0; k < 4; k++ )
+        {
+            __m256i px = _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)( data + i + k * 8 ) ) );
+            q[k] = _mm256_cvttps_epi32( _mm256_mul_ps( _mm256_cvtepi32_ps( px ), g ) );
+        }
+        __m256i out = _mm256_packus_epi16( _mm256_packs_epi32( q[0], q[1] ), _mm256_packs_epi32( q[2], q[3] ) );
+        _mm256_storeu_si256( (__m256i*)( data + i ), _mm256_permutevar8x32_epi32( out, order ) );
+    }
+    gain_float_sse2( data + i, n - i, gain );
+}
+
+__attribute__(( target( "avx2" ) ))
+static void gain_fixed_avx2( uint8_t* data, size_t n, uint16_t gain_q8 )
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i g = _mm256_set1_epi16( (short)gain_q8 );
+    const __m256i max = _mm256_set1_epi16( 255 );
+    size_t i = 0;
+    for( ; i + 32 <= n; i += 32 )
+    {
+        // Unpack and pack both work per 128-bit lane, so byte order is preserved
+        __m256i px = _mm256_loadu_si256( (const __m256i*)( data + i ) );
+        __m256i lo = _mm256_min_epu16( _mm256_mulhi_epu16( _mm256_unpacklo_epi8( zero, px ), g ), max );
+        __m256i hi = _mm256_min_epu16( _mm256_mulhi_epu16( _mm256_unpackhi_epi8( zero, px ), g ), max );
+        _mm256_storeu_si256( (__m256i*)( data + i ), _mm256_packus_epi16( lo, hi ) );
+    }
+    gain_fixed_sse2( data + i, n - i, gain_q8 );
+}
+
+#endif
+
+// --- Public kernels ---
+
+void gain_apply_float( uint8_t* data, size_t n, float gain )
+{
+    switch( isp_isa_active() )
+    {
+#ifdef ISP_X86
+        case ISP_ISA_AVX2:
+            gain_float_avx2( data, n, gain );
+            break;
+        case ISP_ISA_SSE2:
+            gain_float_sse2( data, n, gain );
+            break;
+#endif
+        default:
+            gain_apply_reference( data, n, gain );
+            break;
+    }
+}
+
+uint16_t gain_to_fixed( float gain )
+{
+    float q = gain * 256.0f + 0.5f;
+    return (uint16_t)( q <= 0 ? 0 : q >= 65535.0f ? 65535 : q );
+}
+
+void gain_apply_fixed( uint8_t* data, size_t n, uint16_t gain_q8 )
+{
+    switch( isp_isa_active() )
+    {
+#ifdef ISP_X86
+        case ISP_ISA_AVX2:
+            gain_fixed_avx2( data, n, gain_q8 );
+            break;
+        case ISP_ISA_SSE2:
+            gain_fixed_sse2( data, n, gain_q8 );
+            break;
+#endif
+        default:
+            gain_fixed_scalar( data, n, gain_q8 );
+            break;
+    }
+}
+
+void gain_build_lut( uint8_t lut[256], float gain )
+{
+    for( int value = 0; value < 256; value++ )
+    {
+        lut[value] = (uint8_t)value;
+    }
+    gain_apply_reference( lut, 256, gain );
+}
+
+void gain_apply_lut( uint8_t* data, size_t n, const uint8_t lut[256] )
+{
+    size_t i = 0;
+    // Four independent lookups per iteration keep the load ports busy
+    for( ; i + 4 <= n; i += 4 )
+    {
+        uint8_t a = lut[data[i]];
+        uint8_t b = lut[data[i + 1]];
+        uint8_t c = lut[data[i + 2]];
+        uint8_t d = lut[data[i + 3]];
+        data[i] = a;
+        data[i + 1] = b;
+        data[i + 2] = c;
+        data[i + 3] = d;
+    }
+    for( ; i < n; i++ )
+    {
+        data[i] = lut[data[i]];
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef ISP_GAIN_H
+#define ISP_GAIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "isp_isa.h"
+
+// --- Gain / clamp: out = min( 255, in * gain ), 0 <= gain < 256 ---
+
+// Scalar float, one branch per byte: the definition the others are tested against
+void gain_apply_reference( uint8_t* data, size_t n, float gain );
+
+// Same float math vectorized; bit-exact with the reference
+void gain_apply_float( uint8_t* data, size_t n, float gain );
+
+// Q8.8 integer gain, (in * gain_q8) >> 8. Within 1 of the reference and the
+// fastest path: 16 pixels per multiply on SSE2, 32 on AVX2.
+uint16_t gain_to_fixed( float gain );
+void gain_apply_fixed( uint8_t* data, size_t n, uint16_t gain_q8 );
+
+// Table lookup; exact with the reference for any per-value curve, not only
+// a gain. Scalar on every ISA, byte lookups do not vectorize without gathers.
+void gain_build_lut( uint8_t lut[256], float gain );
+void gain_apply_lut( uint8_t* data, size_t n, const uint8_t lut[256] );
+
+#endif
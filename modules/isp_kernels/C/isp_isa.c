@@ -0,0 +1,62 @@
+#include "isp_isa.h"
+#include <threads.h>
+
+static isp_isa_t active_isa;
+static once_flag detect_once = ONCE_FLAG_INIT;
+
+bool isp_isa_supported( isp_isa_t isa )
+{
+    switch( isa )
+    {
+        case ISP_ISA_SCALAR:
+            return true;
+#ifdef ISP_X86
+        case ISP_ISA_SSE2:
+            return __builtin_cpu_supports( "sse2" );
+        case ISP_ISA_AVX2:
+            return __builtin_cpu_supports( "avx2" );
+#endif
+        default:
+            return false;
+    }
+}
+
+static void detect( void )
+{
+#ifdef ISP_X86
+    __builtin_cpu_init();
+#endif
+    isp_isa_t best = ISP_ISA_SCALAR;
+    for( int isa = ISP_ISA_COUNT - 1; isa > ISP_ISA_SCALAR; isa-- )
+    {
+        if( isp_isa_supported( isa ) )
+        {
+            best = isa;
+            break;
+        }
+    }
+    __atomic_store_n( &active_isa, best, __ATOMIC_RELAXED );
+}
+
+isp_isa_t isp_isa_active( void )
+{
+    call_once( &detect_once, detect );
+    return __atomic_load_n( &active_isa, __ATOMIC_RELAXED );
+}
+
+const char* isp_isa_name( isp_isa_t isa )
+{
+    static const char* names[ISP_ISA_COUNT] = { "scalar", "SSE2", "AVX2" };
+    return isa < ISP_ISA_COUNT ? names[isa] : "unknown";
+}
+
+bool isp_isa_select( isp_isa_t isa )
+{
+    call_once( &detect_once, detect );
+    if( !isp_isa_supported( isa ) )
+    {
+        return false;
+    }
+    __atomic_store_n( &active_isa, isa, __ATOMIC_RELAXED );
+    return true;
+}
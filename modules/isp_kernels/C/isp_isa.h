@@ -0,0 +1,28 @@
+#ifndef ISP_ISA_H
+#define ISP_ISA_H
+
+#include <stdbool.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define ISP_X86 1
+#endif
+
+// Instruction sets the kernels are built for. The best one the CPU supports
+// is picked on first use; x86 builds need no -m flags, the SIMD paths are
+// compiled per function with target attributes.
+typedef enum {
+    ISP_ISA_SCALAR,
+    ISP_ISA_SSE2,
+    ISP_ISA_AVX2,
+    ISP_ISA_COUNT
+} isp_isa_t;
+
+bool isp_isa_supported( isp_isa_t isa );
+isp_isa_t isp_isa_active( void );
+const char* isp_isa_name( isp_isa_t isa );
+
+// Forces an instruction set for every kernel, for tests and benchmarks.
+// Returns false and changes nothing if the CPU lacks it.
+bool isp_isa_select( isp_isa_t isa );
+
+#endif
@@ -0,0 +1,281 @@
+#include "lens_remap.h"
+
+#ifdef ISP_X86
+#include <immintrin.h>
+#endif
+
+// --- Table ---
+
+uint32_t lens_remap_key( uint32_t lens_id, uint32_t width, uint32_t height )
+{
+    return ( lens_id << 22 ) ^ ( width << 11 ) ^ height;
+}
+
+size_t lens_remap_size( uint32_t width, uint32_t height )
+{
+    if( width < 2 || height < 2 || width > LENS_REMAP_MAX_DIM || height > LENS_REMAP_MAX_DIM )
+    {
+        return 0;
+    }
+    size_t grid_w = ( width - 1 ) / LENS_REMAP_GRID + 2;
+    size_t grid_h = ( height - 1 ) / LENS_REMAP_GRID + 2;
+    return sizeof( lens_remap_t ) + grid_w * grid_h * sizeof( lens_remap_node_t );
+}
+
+// Rounds to fixed point, clamped to [min, max]; NaN from a broken model lands on min
+static int32_t to_fixed( double value, int32_t min, int32_t max )
+{
+    if( !( value > min ) )
+    {
+        return min;
+    }
+    return value >= max ? max : (int32_t)( value + 0.5 );
+}
+
+bool lens_remap_build( lens_remap_t* table, uint32_t lens_id, const lens_model_t* model,
+                       uint32_t width, uint32_t height )
+{
+    if( !lens_remap_size( width, height ) )
+    {
+        return false;
+    }
+    table->lens_id = lens_id;
+    table->width = width;
+    table->height = height;
+    table->grid_w = ( width - 1 ) / LENS_REMAP_GRID + 2;
+    table->grid_h = ( height - 1 ) / LENS_REMAP_GRID + 2;
+
+    double cx = ( width - 1 ) * 0.5;
+    double cy = ( height - 1 ) * 0.5;
+    double inv_corner2 = 1.0 / ( cx * cx + cy * cy );
+    // Nodes past the edge keep their true position, so the cells along the
+    // edge interpolate like any other; the kernel clamps per pixel. The
+    // margin bounds the steps between nodes for models that blow up there.
+    int32_t margin = LENS_REMAP_GRID << 16;
+    int32_t max_x = (int32_t)( width - 1 ) << 16;
+    int32_t max_y = (int32_t)( height - 1 ) << 16;
+    lens_remap_node_t* node = table->nodes;
+    for( uint32_t gy = 0; gy < table->grid_h; gy++ )
+    {
+        for( uint32_t gx = 0; gx < table->grid_w; gx++, node++ )
+        {
+            double u = (double)gx * LENS_REMAP_GRID - cx;
+            double v = (double)gy * LENS_REMAP_GRID - cy;
+            double r2 = ( u * u + v * v ) * inv_corner2;
+            double poly = 0;
+            for( int k = 5; k >= 0; k-- )
+            {
+                poly = poly * r2 + model->distortion_k[k];
+            }
+            double scale = 1.0 + poly * r2;
+            // Vignetting happens on the sensor, so its gain follows the source radius
+            double src_r2 = r2 * scale * scale;
+            double gain = model->gain * ( 1.0 + src_r2 * ( model->vignette[0] + src_r2 *
+                                        ( model->vignette[1] + src_r2 * model->vignette[2] ) ) );
+            node->x = to_fixed( ( cx + u * scale ) * 65536.0, -margin, max_x + margin );
+            node->y = to_fixed( ( cy + v * scale ) * 65536.0, -margin, max_y + margin );
+            node->gain = to_fixed( gain * 256.0, 0, 65535 );
+        }
+    }
+    return true;
+}
+
+// --- Scalar ---
+
+// Rounded ( a * ( 256 - w ) + b * w ) / 256
+static inline uint32_t lerp8( uint32_t a, uint32_t b, uint32_t w )
+{
+    return ( a * ( 256 - w ) + b * w + 128 ) >> 8;
+}
+
+// Pixels t .. t + n - 1 of one mesh cell; pixel t samples at left + step * t.
+// Rounding the step down can undershoot by a few units, so every value is
+// clamped to the frame (and the gain to 0) per pixel.
+typedef void (*remap_span_fn)( const lens_remap_t* table, const uint8_t* src, uint8_t* dst,
+                               const lens_remap_node_t* left, const lens_remap_node_t* step,
+                               int32_t t, uint32_t n );
+
+static inline int32_t clamp32( int32_t value, int32_t max )
+{
+    return value < 0 ? 0 : value > max ? max : value;
+}
+
+static void remap_span_scalar( const lens_remap_t* table, const uint8_t* src, uint8_t* dst,
+                               const lens_remap_node_t* left, const lens_remap_node_t* step,
+                               int32_t t, uint32_t n )
+{
+    size_t stride = (size_t)table->width * 3;
+    int32_t max_x = (int32_t)( table->width - 1 ) << 16;
+    int32_t max_y = (int32_t)( table->height - 1 ) << 16;
+    for( uint32_t i = 0; i < n; i++, t++, dst += 3 )
+    {
+        int32_t sx = clamp32( left->x + step->x * t, max_x );
+        int32_t sy = clamp32( left->y + step->y * t, max_y );
+        uint32_t gain = clamp32( left->gain + step->gain * t, 65535 );
+        uint32_t x = sx >> 16;
+        uint32_t y = sy >> 16;
+        uint32_t fx = ( sx >> 8 ) & 255;
+        uint32_t fy = ( sy >> 8 ) & 255;
+        // The far neighbours repeat the edge; their weight is 0 there anyway
+        size_t x0 = x * 3;
+        size_t x1 = ( x + 1 < table->width ? x + 1 : x ) * 3;
+        const uint8_t* row0 = src + y * stride;
+        const uint8_t* row1 = src + ( y + 1 < table->height ? y + 1 : y ) * stride;
+        for( int c = 0; c < 3; c++ )
+        {
+            uint32_t top = lerp8( row0[x0 + c], row0[x1 + c], fx );
+            uint32_t bottom = lerp8( row1[x0 + c], row1[x1 + c], fx );
+            uint32_t value = ( lerp8( top, bottom, fy ) * gain ) >> 8;
+            dst[c] = (uint8_t)( value > 255 ? 255 : value );
+        }
+    }
+}
+
+#ifdef ISP_X86
+
+// --- AVX2 ---
+
+// lerp8 on 16-bit lanes; a * ( 256 - w ) + b * w + 128 stays below 65536
+__attribute__(( target( "avx2" ) ))
+static inline __m256i lerp8_epi16( __m256i a, __m256i b, __m256i w )
+{
+    __m256i inv = _mm256_sub_epi16( _mm256_set1_epi16( 256 ), w );
+    __m256i sum = _mm256_add_epi16( _mm256_mullo_epi16( a, inv ), _mm256_mullo_epi16( b, w ) );
+    return _mm256_srli_epi16( _mm256_add_epi16( sum, _mm256_set1_epi16( 128 ) ), 8 );
+}
+
+__attribute__(( target( "avx2" ) ))
+static void remap_span_avx2( const lens_remap_t* table, const uint8_t* src, uint8_t* dst,
+                             const lens_remap_node_t* left, const lens_remap_node_t* step,
+                             int32_t t, uint32_t n )
+{
+    const __m256i lane = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+    const __m256i left_x = _mm256_set1_epi32( left->x );
+    const __m256i left_y = _mm256_set1_epi32( left->y );
+    const __m256i left_gain = _mm256_set1_epi32( left->gain );
+    const __m256i step_x = _mm256_set1_epi32( step->x );
+    const __m256i step_y = _mm256_set1_epi32( step->y );
+    const __m256i step_gain = _mm256_set1_epi32( step->gain );
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max_x = _mm256_set1_epi32( (int)( table->width - 1 ) << 16 );
+    const __m256i max_y = _mm256_set1_epi32( (int)( table->height - 1 ) << 16 );
+    const __m256i max_gain = _mm256_set1_epi32( 65535 );
+    const __m256i stride = _mm256_set1_epi32( (int)table->width * 3 );
+    const __m256i three = _mm256_set1_epi32( 3 );
+    const __m256i one = _mm256_set1_epi32( 1 );
+    const __m256i last_x = _mm256_set1_epi32( (int)table->width - 1 );
+    const __m256i last_y = _mm256_set1_epi32( (int)table->height - 1 );
+    const __m256i byte = _mm256_set1_epi32( 255 );
+    const __m256i even = _mm256_set1_epi32( 0x00FF00FF );
+    const __m256i max = _mm256_set1_epi16( 255 );
+    // RGBx dwords to packed RGB: 12 bytes per 128-bit lane, then the two lanes joined
+    const __m256i pack = _mm256_setr_epi8( 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                           0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 );
+    const __m256i join = _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 3, 7 );
+    const int* base = (const int*)src;
+    for( ; n >= 8; n -= 8, t += 8, dst += 24 )
+    {
+        __m256i tv = _mm256_add_epi32( _mm256_set1_epi32( t ), lane );
+        __m256i sx = _mm256_add_epi32( left_x, _mm256_mullo_epi32( step_x, tv ) );
+        __m256i sy = _mm256_add_epi32( left_y, _mm256_mullo_epi32( step_y, tv ) );
+        __m256i gain = _mm256_add_epi32( left_gain, _mm256_mullo_epi32( step_gain, tv ) );
+        sx = _mm256_min_epi32( _mm256_max_epi32( sx, zero ), max_x );
+        sy = _mm256_min_epi32( _mm256_max_epi32( sy, zero ), max_y );
+        gain = _mm256_min_epi32( _mm256_max_epi32( gain, zero ), max_gain );
+        __m256i x = _mm256_srli_epi32( sx, 16 );
+        __m256i y = _mm256_srli_epi32( sy, 16 );
+        // Weights and gain repeated in both 16-bit halves, one per channel pair
+        __m256i fx = _mm256_and_si256( _mm256_srli_epi32( sx, 8 ), byte );
+        __m256i fy = _mm256_and_si256( _mm256_srli_epi32( sy, 8 ), byte );
+        fx = _mm256_or_si256( fx, _mm256_slli_epi32( fx, 16 ) );
+        fy = _mm256_or_si256( fy, _mm256_slli_epi32( fy, 16 ) );
+        gain = _mm256_or_si256( gain, _mm256_slli_epi32( gain, 16 ) );
+
+        __m256i x0 = _mm256_mullo_epi32( x, three );
+        __m256i x1 = _mm256_mullo_epi32( _mm256_min_epu32( _mm256_add_epi32( x, one ), last_x ), three );
+        __m256i y0 = _mm256_mullo_epi32( y, stride );
+        __m256i y1 = _mm256_mullo_epi32( _mm256_min_epu32( _mm256_add_epi32( y, one ), last_y ), stride );
+        // One dword per neighbour: its RGB plus a byte of the next pixel, hence the source padding
+        __m256i p00 = _mm256_i32gather_epi32( base, _mm256_add_epi32( y0, x0 ), 1 );
+        __m256i p01 = _mm256_i32gather_epi32( base, _mm256_add_epi32( y0, x1 ), 1 );
+        __m256i p10 = _mm256_i32gather_epi32( base, _mm256_add_epi32( y1, x0 ), 1 );
+        __m256i p11 = _mm256_i32gather_epi32( base, _mm256_add_epi32( y1, x1 ), 1 );
+
+        // R and B in the even bytes, G and the spare byte in the odd ones, each widened to 16 bits
+        __m256i rb = lerp8_epi16( lerp8_epi16( _mm256_and_si256( p00, even ), _mm256_and_si256( p01, even ), fx ),
+                                  lerp8_epi16( _mm256_and_si256( p10, even ), _mm256_and_si256( p11, even ), fx ), fy );
+        __m256i gx = lerp8_epi16( lerp8_epi16( _mm256_and_si256( _mm256_srli_epi32( p00, 8 ), even ),
+                                               _mm256_and_si256( _mm256_srli_epi32( p01, 8 ), even ), fx ),
+                                  lerp8_epi16( _mm256_and_si256( _mm256_srli_epi32( p10, 8 ), even ),
+                                               _mm256_and_si256( _mm256_srli_epi32( p11, 8 ), even ), fx ), fy );
+        // mulhi( v << 8, gain ) = ( v * gain ) >> 8, as in the fixed-point gain kernel
+        rb = _mm256_min_epu16( _mm256_mulhi_epu16( _mm256_slli_epi16( rb, 8 ), gain ), max );
+        gx = _mm256_min_epu16( _mm256_mulhi_epu16( _mm256_slli_epi16( gx, 8 ), gain ), max );
+
+        __m256i rgb = _mm256_or_si256( rb, _mm256_slli_epi16( gx, 8 ) );
+        rgb = _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( rgb, pack ), join );
+        // Exactly 24 bytes: the next pixels may belong to a rectangle another thread is writing
+        _mm_storeu_si128( (__m128i*)dst, _mm256_castsi256_si128( rgb ) );
+        _mm_storel_epi64( (__m128i*)( dst + 16 ), _mm256_extracti128_si256( rgb, 1 ) );
+    }
+    remap_span_scalar( table, src, dst, left, step, t, n );
+}
+
+#endif
+
+// --- Public kernel ---
+
+// Per-pixel step from node a to node b; dividing before multiplying keeps
+// step * t in range for any node spacing the margin allows
+static inline lens_remap_node_t node_step( const lens_remap_node_t* a, const lens_remap_node_t* b )
+{
+    lens_remap_node_t step = { ( b->x - a->x ) >> LENS_REMAP_GRID_SHIFT,
+                               ( b->y - a->y ) >> LENS_REMAP_GRID_SHIFT,
+                               ( b->gain - a->gain ) >> LENS_REMAP_GRID_SHIFT };
+    return step;
+}
+
+// Node values on row ty of a mesh cell
+static inline lens_remap_node_t node_lerp( const lens_remap_node_t* above, const lens_remap_node_t* below, int32_t ty )
+{
+    lens_remap_node_t step = node_step( above, below );
+    lens_remap_node_t node = { above->x + step.x * ty, above->y + step.y * ty, above->gain + step.gain * ty };
+    return node;
+}
+
+void lens_remap_apply( const lens_remap_t* table, const uint8_t* src, uint8_t* dst,
+                       uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 )
+{
+    remap_span_fn span = remap_span_scalar;
+    switch( isp_isa_active() )
+    {
+#ifdef ISP_X86
+        case ISP_ISA_AVX2:
+            span = remap_span_avx2;
+            break;
+#endif
+        default:
+            // SSE2 has no gathers; per-lane loads would be no faster than the scalar loop
+            break;
+    }
+    size_t stride = (size_t)table->width * 3;
+    for( uint32_t y = y0; y < y1; y++ )
+    {
+        const lens_remap_node_t* above = table->nodes + (size_t)( y >> LENS_REMAP_GRID_SHIFT ) * table->grid_w;
+        const lens_remap_node_t* below = above + table->grid_w;
+        int32_t ty = y & ( LENS_REMAP_GRID - 1 );
+        uint32_t x = x0;
+        while( x < x1 )
+        {
+            uint32_t cell = x >> LENS_REMAP_GRID_SHIFT;
+            uint32_t end = ( cell + 1 ) << LENS_REMAP_GRID_SHIFT;
+            end = end < x1 ? end : x1;
+            lens_remap_node_t left = node_lerp( &above[cell], &below[cell], ty );
+            lens_remap_node_t right = node_lerp( &above[cell + 1], &below[cell + 1], ty );
+            lens_remap_node_t step = node_step( &left, &right );
+            span( table, src, dst + y * stride + (size_t)x * 3, &left, &step,
+                  x & ( LENS_REMAP_GRID - 1 ), end - x );
+            x = end;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef LENS_REMAP_H
+#define LENS_REMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "isp_isa.h"
+
+#define LENS_REMAP_GRID_SHIFT  4
+#define LENS_REMAP_GRID        ( 1 << LENS_REMAP_GRID_SHIFT )   // Pixels between mesh nodes
+#define LENS_REMAP_MAX_DIM     8192     // Keeps Q16.16 coordinates and byte offsets in int32
+#define LENS_REMAP_SRC_PAD     4        // Readable bytes the source needs past its last pixel
+
+// --- Lens model, evaluated only when a table is built ---
+// r is the distance from the image centre, 1.0 at the corners.
+typedef struct {
+    float distortion_k[6];      // r_src = r * ( 1 + k0 r^2 + k1 r^4 + ... + k5 r^12 )
+    float vignette[3];          // Gain at source radius r: 1 + v0 r^2 + v1 r^4 + v2 r^6
+    float gain;                 // Overall gain, folded into the vignette gain
+} lens_model_t;
+
+// One mesh node: where the output pixel at this node samples the source, and
+// the gain it gets. Pixels between nodes interpolate linearly.
+typedef struct {
+    int32_t x;                  // Source column, Q16.16
+    int32_t y;                  // Source row, Q16.16
+    int32_t gain;               // Q8.8, at most 65535
+} lens_remap_node_t;
+
+// --- Remap + vignette table for one lens at one resolution ---
+// A node every LENS_REMAP_GRID pixels: about 100 KB at 1080p, where a
+// per-pixel map would take megabytes and stream through the caches every frame.
+typedef struct {
+    uint32_t lens_id;
+    uint32_t width;
+    uint32_t height;
+    uint32_t grid_w;            // Nodes per mesh row, one past the last pixel
+    uint32_t grid_h;
+    lens_remap_node_t nodes[];  // grid_h rows of grid_w
+} lens_remap_t;
+
+// Cache key for a lens at a resolution; unique while lens_id < 1024 and both
+// dimensions are below 2048, so check the table's fields on a hit
+uint32_t lens_remap_key( uint32_t lens_id, uint32_t width, uint32_t height );
+
+// Bytes needed for a table, 0 unless 2 <= width, height <= LENS_REMAP_MAX_DIM
+size_t lens_remap_size( uint32_t width, uint32_t height );
+
+// Fills a table of lens_remap_size() bytes. Samples that land outside the
+// frame are clamped to its edge.
+bool lens_remap_build( lens_remap_t* table, uint32_t lens_id, const lens_model_t* model,
+                       uint32_t width, uint32_t height );
+
+// Corrects the output rectangle [x0, x1) x [y0, y1) of dst from src, both
+// packed RGB frames of the table's size: each output pixel is a bilinear
+// sample of src at its remapped position times its vignette gain, clamped
+// to 255. src must not overlap dst and needs LENS_REMAP_SRC_PAD readable
+// bytes past its end. Rectangles that do not overlap can run in parallel.
+// AVX2 gathers eight pixels at a time; without AVX2 the scalar path runs,
+// byte for byte the same.
+void lens_remap_apply( const lens_remap_t* table, const uint8_t* src, uint8_t* dst,
+                       uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 );
+
+#endif
@@ -0,0 +1,183 @@
+#include "sensor_fill.h"
+
+#ifdef ISP_X86
+#include <immintrin.h>
+#endif
+
+#define FILL_BLOCK 16   // Bytes per PRNG step of the four streams
+
+static uint32_t xorshift32( uint32_t x )
+{
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+static void noise_init( uint32_t state[4], uint32_t noise_seed )
+{
+    for( uint32_t k = 0; k < 4; k++ )
+    {
+        // Spread nearby seeds apart; xorshift must never start at 0
+        uint32_t x = ( noise_seed + k ) * 0x9E3779B9u;
+        x ^= x >> 16;
+        state[k] = x ? x : 0x6C078965u;
+    }
+}
+
+// Fills n bytes whose first one is byte 'offset' of the frame (a multiple of
+// FILL_BLOCK), continuing the noise streams from state
+static void fill_scalar( uint8_t* data, size_t n, size_t offset, uint8_t seed, uint32_t state[4], uint32_t noise_bits )
+{
+    if( !noise_bits )
+    {
+        for( size_t i = 0; i < n; i++ )
+        {
+            data[i] = (uint8_t)( offset + i + seed );
+        }
+        return;
+    }
+    uint32_t mask = ( 1u << noise_bits ) - 1;
+    uint32_t half = mask >> 1;
+    for( size_t block = 0; block < n; block += FILL_BLOCK )
+    {
+        size_t len = n - block < FILL_BLOCK ? n - block : FILL_BLOCK;
+        for( size_t j = 0; j < len; j++ )
+        {
+            uint32_t value = (uint8_t)( offset + block + j + seed );
+            value += ( state[j / 4] >> ( 8 * ( j % 4 ) ) ) & mask;
+            value = value > 255 ? 255 : value;
+            data[block + j] = (uint8_t)( value > half ? value - half : 0 );
+        }
+        for( int k = 0; k < 4; k++ )
+        {
+            state[k] = xorshift32( state[k] );
+        }
+    }
+}
+
+void sensor_fill_reference( uint8_t* data, size_t n, uint8_t seed, uint32_t noise_seed, uint32_t noise_bits )
+{
+    uint32_t state[4];
+    noise_init( state, noise_seed );
+    fill_scalar( data, n, 0, seed, state, noise_bits > SENSOR_NOISE_MAX_BITS ? SENSOR_NOISE_MAX_BITS : noise_bits );
+}
+
+#ifdef ISP_X86
+
+__attribute__(( target( "sse2" ) ))
+static __m128i xorshift32_sse2( __m128i x )
+{
+    x = _mm_xor_si128( x, _mm_slli_epi32( x, 13 ) );
+    x = _mm_xor_si128( x, _mm_srli_epi32( x, 17 ) );
+    return _mm_xor_si128( x, _mm_slli_epi32( x, 5 ) );
+}
+
+__attribute__(( target( "sse2" ) ))
+static size_t fill_sse2( uint8_t* data, size_t n, uint8_t seed, uint32_t state[4], uint32_t noise_bits, bool stream )
+{
+    __m128i value = _mm_add_epi8( _mm_setr_epi8( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ),
+                                  _mm_set1_epi8( (char)seed ) );
+    const __m128i step = _mm_set1_epi8( FILL_BLOCK );
+    const __m128i mask = _mm_set1_epi8( (char)( ( 1u << noise_bits ) - 1 ) );
+    const __m128i half = _mm_set1_epi8( (char)( ( ( 1u << noise_bits ) - 1 ) >> 1 ) );
+    __m128i noise = _mm_loadu_si128( (const __m128i*)state );
+    size_t i = 0;
+    for( ; i + FILL_BLOCK <= n; i += FILL_BLOCK )
+    {
+        __m128i out = value;
+        value = _mm_add_epi8( value, step );
+        if( noise_bits )
+        {
+            out = _mm_subs_epu8( _mm_adds_epu8( out, _mm_and_si128( noise, mask ) ), half );
+            noise = xorshift32_sse2( noise );
+        }
+        if( stream )
+        {
+            _mm_stream_si128( (__m128i*)( data + i ), out );
+        }
+        else
+        {
+            _mm_storeu_si128( (__m128i*)( data + i ), out );
+        }
+    }
+    if( stream )
+    {
+        // Streaming stores are weakly ordered; publish them before the frame is handed on
+        _mm_sfence();
+    }
+    _mm_storeu_si128( (__m128i*)state, noise );
+    return i;
+}
+
+__attribute__(( target( "avx2" ) ))
+static __m256i xorshift32_avx2( __m256i x )
+{
+    x = _mm256_xor_si256( x, _mm256_slli_epi32( x, 13 ) );
+    x = _mm256_xor_si256( x, _mm256_srli_epi32( x, 17 ) );
+    return _mm256_xor_si256( x, _mm256_slli_epi32( x, 5 ) );
+}
+
+__attribute__(( target( "avx2" ) ))
+static size_t fill_avx2( uint8_t* data, size_t n, uint8_t seed, uint32_t state[4], uint32_t noise_bits, bool stream )
+{
+    __m256i value = _mm256_add_epi8( _mm256_setr_epi8( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                                       16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31 ),
+                                     _mm256_set1_epi8( (char)seed ) );
+    const __m256i step = _mm256_set1_epi8( 2 * FILL_BLOCK );
+    const __m256i mask = _mm256_set1_epi8( (char)( ( 1u << noise_bits ) - 1 ) );
+    const __m256i half = _mm256_set1_epi8( (char)( ( ( 1u << noise_bits ) - 1 ) >> 1 ) );
+    // Low lane holds the streams at block t, high lane one step on at block t + 1
+    __m128i lo = _mm_loadu_si128( (const __m128i*)state );
+    __m256i noise = _mm256_inserti128_si256( _mm256_castsi128_si256( lo ), xorshift32_sse2( lo ), 1 );
+    size_t i = 0;
+    for( ; i + 2 * FILL_BLOCK <= n; i += 2 * FILL_BLOCK )
+    {
+        __m256i out = value;
+        value = _mm256_add_epi8( value, step );
+        if( noise_bits )
+        {
+            out = _mm256_subs_epu8( _mm256_adds_epu8( out, _mm256_and_si256( noise, mask ) ), half );
+            noise = xorshift32_avx2( xorshift32_avx2( noise ) );
+        }
+        if( stream )
+        {
+            _mm256_stream_si256( (__m256i*)( data + i ), out );
+        }
+        else
+        {
+            _mm256_storeu_si256( (__m256i*)( data + i ), out );
+        }
+    }
+    if( stream )
+    {
+        _mm_sfence();
+    }
+    _mm_storeu_si128( (__m128i*)state, _mm256_castsi256_si128( noise ) );
+    return i;
+}
+
+#endif
+
+void sensor_fill( uint8_t* data, size_t n, uint8_t seed, uint32_t noise_seed, uint32_t noise_bits, bool stream )
+{
+    uint32_t state[4];
+    noise_init( state, noise_seed );
+    noise_bits = noise_bits > SENSOR_NOISE_MAX_BITS ? SENSOR_NOISE_MAX_BITS : noise_bits;
+    size_t done = 0;
+    switch( isp_isa_active() )
+    {
+#ifdef ISP_X86
+        case ISP_ISA_AVX2:
+            // Streaming stores need the vector width's alignment; frames are 64-byte aligned
+            done = fill_avx2( data, n, seed, state, noise_bits, stream && ( (uintptr_t)data & 31 ) == 0 );
+            break;
+        case ISP_ISA_SSE2:
+            done = fill_sse2( data, n, seed, state, noise_bits, stream && ( (uintptr_t)data & 15 ) == 0 );
+            break;
+#endif
+        default:
+            break;
+    }
+    fill_scalar( data + done, n - done, done, seed, state, noise_bits );
+}
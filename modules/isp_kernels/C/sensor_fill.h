@@ -0,0 +1,26 @@
+#ifndef SENSOR_FILL_H
+#define SENSOR_FILL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "isp_isa.h"
+
+#define SENSOR_NOISE_MAX_BITS 8
+
+// --- Synthetic sensor readout ---
+// Byte i is ( i + seed ) % 256, the gradient the sensor thread has always
+// written. With noise_bits > 0 each byte also gets zero-centred noise of
+// that many bits from four xorshift32 streams seeded by noise_seed; every
+// 16-byte block takes one step of all four, so vector and scalar code
+// produce the same bytes.
+
+// Scalar, the definition the vector paths are tested against
+void sensor_fill_reference( uint8_t* data, size_t n, uint8_t seed, uint32_t noise_seed, uint32_t noise_bits );
+
+// Vectorized on SSE2/AVX2. With stream set and data aligned to the vector
+// width, writes bypass the cache with non-temporal stores: a frame the ISP
+// reads later should not evict what the ISP is working on now.
+void sensor_fill( uint8_t* data, size_t n, uint8_t seed, uint32_t noise_seed, uint32_t noise_bits, bool stream );
+
+#endif
@@ -0,0 +1,205 @@
+// test_main.c
+#include "isp_gain.h"
+#include "sensor_fill.h"
+#include "lens_remap.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LEN 1000
+
+static const float gains[] = { 0.0f, 0.5f, 1.0f, 1.2f, 1.6f, 2.55f, 3.7f, 200.0f, 255.9f };
+#define GAIN_COUNT ( sizeof( gains ) / sizeof( gains[0] ) )
+
+static uint8_t input[MAX_LEN + 64];
+static uint8_t expect[MAX_LEN + 64];
+static uint8_t fixed_scalar[MAX_LEN + 64];
+static uint8_t actual[MAX_LEN + 64];
+
+// Lengths around every vector width, plus misaligned starts
+static void for_each_case( void (*check)( size_t offset, size_t len, float gain ) )
+{
+    for( size_t g = 0; g < GAIN_COUNT; g++ )
+    {
+        for( size_t offset = 0; offset < 3; offset++ )
+        {
+            for( size_t len = 0; len <= 100; len++ )
+            {
+                check( offset, len, gains[g] );
+            }
+            check( offset, MAX_LEN, gains[g] );
+        }
+    }
+}
+
+static void check_float( size_t offset, size_t len, float gain )
+{
+    memcpy( expect, input, sizeof( input ) );
+    memcpy( actual, input, sizeof( input ) );
+    gain_apply_reference( expect + offset, len, gain );
+    gain_apply_float( actual + offset, len, gain );
+    // Bytes outside the range must be untouched as well
+    assert( memcmp( expect, actual, sizeof( input ) ) == 0 );
+}
+
+static void check_fixed( size_t offset, size_t len, float gain )
+{
+    uint16_t gain_q8 = gain_to_fixed( gain );
+    isp_isa_t isa = isp_isa_active();
+    isp_isa_select( ISP_ISA_SCALAR );
+    memcpy( fixed_scalar, input, sizeof( input ) );
+    gain_apply_fixed( fixed_scalar + offset, len, gain_q8 );
+    isp_isa_select( isa );
+
+    memcpy( actual, input, sizeof( input ) );
+    gain_apply_fixed( actual + offset, len, gain_q8 );
+    assert( memcmp( fixed_scalar, actual, sizeof( input ) ) == 0 );
+
+    memcpy( expect, input, sizeof( input ) );
+    gain_apply_reference( expect + offset, len, gain );
+    for( size_t i = 0; i < sizeof( input ); i++ )
+    {
+        assert( abs( (int)expect[i] - (int)actual[i] ) <= 1 );
+    }
+}
+
+static void check_lut( size_t offset, size_t len, float gain )
+{
+    uint8_t lut[256];
+    gain_build_lut( lut, gain );
+    memcpy( expect, input, sizeof( input ) );
+    memcpy( actual, input, sizeof( input ) );
+    gain_apply_reference( expect + offset, len, gain );
+    gain_apply_lut( actual + offset, len, lut );
+    assert( memcmp( expect, actual, sizeof( input ) ) == 0 );
+}
+
+// Vector fill matches the scalar definition for every length, alignment,
+// noise setting and store kind; bytes past n stay untouched
+static void check_fill( void )
+{
+    static _Alignas( 64 ) uint8_t fill_expect[MAX_LEN + 64];
+    static _Alignas( 64 ) uint8_t fill_actual[MAX_LEN + 64];
+    for( uint32_t bits = 0; bits <= SENSOR_NOISE_MAX_BITS; bits++ )
+    {
+        for( size_t offset = 0; offset < 64; offset += 13 )
+        {
+            for( size_t len = 0; len <= MAX_LEN; len += ( len < 100 ? 1 : 179 ) )
+            {
+                for( int stream = 0; stream < 2; stream++ )
+                {
+                    uint8_t seed = (uint8_t)( len * 7 + bits );
+                    memset( fill_expect, 0xA5, sizeof( fill_expect ) );
+                    memset( fill_actual, 0xA5, sizeof( fill_actual ) );
+                    sensor_fill_reference( fill_expect + offset, len, seed, (uint32_t)len, bits );
+                    sensor_fill( fill_actual + offset, len, seed, (uint32_t)len, bits, stream );
+                    assert( memcmp( fill_expect, fill_actual, sizeof( fill_expect ) ) == 0 );
+                }
+            }
+        }
+    }
+}
+
+#define REMAP_W 203     // Not a multiple of the mesh grid or of a vector
+#define REMAP_H 61
+#define REMAP_BYTES ( REMAP_W * REMAP_H * 3 )
+
+static uint8_t remap_src[REMAP_BYTES + LENS_REMAP_SRC_PAD];
+static uint8_t remap_expect[REMAP_BYTES];
+static uint8_t remap_actual[REMAP_BYTES];
+
+// Full frame and sub-rectangles match the scalar path; pixels outside a rectangle stay untouched
+static void check_remap( const lens_remap_t* table )
+{
+    static const uint32_t rects[][4] = { { 0, 0, REMAP_W, REMAP_H }, { 5, 3, 37, 20 },
+                                         { 16, 16, 32, 17 }, { 190, 50, 203, 61 }, { 7, 9, 8, 10 } };
+    for( size_t r = 0; r < sizeof( rects ) / sizeof( rects[0] ); r++ )
+    {
+        const uint32_t* rect = rects[r];
+        isp_isa_t isa = isp_isa_active();
+        isp_isa_select( ISP_ISA_SCALAR );
+        memset( remap_expect, 0xA5, sizeof( remap_expect ) );
+        lens_remap_apply( table, remap_src, remap_expect, rect[0], rect[1], rect[2], rect[3] );
+        isp_isa_select( isa );
+
+        memset( remap_actual, 0xA5, sizeof( remap_actual ) );
+        lens_remap_apply( table, remap_src, remap_actual, rect[0], rect[1], rect[2], rect[3] );
+        assert( memcmp( remap_expect, remap_actual, sizeof( remap_actual ) ) == 0 );
+        for( uint32_t y = 0; y < REMAP_H; y++ )
+        {
+            for( uint32_t x = 0; x < REMAP_W; x++ )
+            {
+                bool inside = x >= rect[0] && x < rect[2] && y >= rect[1] && y < rect[3];
+                if( !inside )
+                {
+                    assert( remap_actual[( y * REMAP_W + x ) * 3] == 0xA5 );
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    // Every byte value appears, then pseudo-random fill
+    for( size_t i = 0; i < sizeof( input ); i++ )
+    {
+        input[i] = i < 256 ? (uint8_t)i : (uint8_t)( ( i * 2654435761u ) >> 24 );
+    }
+    printf( "Best ISA: %s\n", isp_isa_name( isp_isa_active() ) );
+
+    for( size_t i = 0; i < sizeof( remap_src ); i++ )
+    {
+        remap_src[i] = (uint8_t)( ( i * 2654435761u ) >> 24 );
+    }
+    lens_model_t model = { { -0.30f, 0.08f, -0.01f, 0, 0, 0 }, { 0.45f, 0.10f, 0 }, 1.3f };
+    lens_remap_t* barrel = malloc( lens_remap_size( REMAP_W, REMAP_H ) );
+    assert( barrel && lens_remap_build( barrel, 3, &model, REMAP_W, REMAP_H ) );
+    assert( lens_remap_size( 1, REMAP_H ) == 0 );
+
+    int tested = 0;
+    for( int isa = 0; isa < ISP_ISA_COUNT; isa++ )
+    {
+        if( !isp_isa_select( isa ) )
+        {
+            printf( "Skipping %s: not supported\n", isp_isa_name( isa ) );
+            continue;
+        }
+        // 1. Float kernel is bit-exact with the scalar reference
+        for_each_case( check_float );
+        // 2. Fixed-point matches its scalar form exactly and the reference within 1
+        for_each_case( check_fixed );
+        printf( "Test %s passed: float exact, fixed-point within 1\n", isp_isa_name( isa ) );
+        // 3. Sensor fill matches the scalar pattern and noise streams
+        check_fill();
+        printf( "Test %s sensor fill passed\n", isp_isa_name( isa ) );
+        // 4. Lens remap matches the scalar path on a barrel lens with vignetting
+        check_remap( barrel );
+        printf( "Test %s lens remap passed\n", isp_isa_name( isa ) );
+        tested++;
+    }
+    assert( tested > 0 );
+
+    // 5. Without noise the fill is the original ( i + seed ) % 256 gradient
+    static uint8_t gradient[MAX_LEN];
+    sensor_fill( gradient, MAX_LEN, 200, 1, 0, true );
+    for( size_t i = 0; i < MAX_LEN; i++ )
+    {
+        assert( gradient[i] == ( i + 200 ) % 256 );
+    }
+    printf( "Test gradient passed\n" );
+
+    // 6. LUT is exact with the reference
+    for_each_case( check_lut );
+    printf( "Test LUT passed\n" );
+
+    // 7. A lens with no distortion, no vignetting and unit gain copies the frame
+    lens_model_t flat = { { 0 }, { 0 }, 1.0f };
+    assert( lens_remap_build( barrel, 0, &flat, REMAP_W, REMAP_H ) );
+    lens_remap_apply( barrel, remap_src, remap_actual, 0, 0, REMAP_W, REMAP_H );
+    assert( memcmp( remap_src, remap_actual, REMAP_BYTES ) == 0 );
+    printf( "Test identity remap passed\n" );
+    free( barrel );
+    return 0;
+}
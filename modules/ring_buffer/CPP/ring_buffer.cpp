@@ -1,10 +1,41 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <cassert>
+#include <cstdint>
 #include "ring_buffer.h"
 
 using namespace std;
 
+// Aligned storage: containers on AlignedAllocator keep their alignment and
+// contents across reallocation, and ring buffer slots sit on their own lines
+void testAlignedStorage()
+{
+	vector<int, AlignedAllocator<int, 64>> values;
+	const int* first = nullptr;
+	for( int i = 0; i < 1000; i++ )
+	{
+		values.push_back( i );
+		if( i == 0 )
+		{
+			first = values.data();
+		}
+	}
+	assert( values.data() != first );	// Grew past at least one reallocation
+	assert( reinterpret_cast<uintptr_t>( values.data() ) % 64 == 0 );
+	for( int i = 0; i < 1000; i++ )
+	{
+		assert( values[i] == i );
+	}
+
+	RingBuffer<string> buffer( 4, 1 );
+	for( size_t i = 0; i < buffer.getCapacity(); i++ )
+	{
+		assert( reinterpret_cast<uintptr_t>( buffer.slotAddress( i ) ) % RingBuffer<string>::slotAlignment() == 0 );
+	}
+	cout << "Aligned storage checks passed" << endl;
+}
+
 // Demo: Fast producer with overwriting
 template <typename T>
 void fastProducerUnconditional(RingBuffer<T>& buffer, vector<T> data) {
@@ -86,6 +117,7 @@ void fastConsumer(RingBuffer<T>& buffer, size_t size ) {
 
 
 int main() {
+	testAlignedStorage();
 	cout << "Testing message streaming with ring buffer" << endl;
 	vector<string> message = { "The", "quick", "brown", "fox", "leapt", "Across", "the", "room" };
 	size_t size = message.size() - 4;
@@ -3,6 +3,7 @@
 #include <condition_variable>
 #include <memory>
 #include <optional>
+#include "../../aligned_malloc/aligned_allocator.h"
 
 using namespace std;
 template <typename T>
@@ -82,8 +83,36 @@ public:
 		return max_size;
 	}
 
+	/*
+	* @brief: Address of a slot's storage, for checking slot placement
+	* @params: Slot index, below getCapacity()
+	* @returns: Pointer to the slot
+	*/
+	const void* slotAddress( size_t index ) const noexcept
+	{
+		return &buf[index];
+	}
+
+	/*
+	* @brief: Alignment every slot is placed at
+	* @params: None
+	* @returns: alignof of the slot type
+	*/
+	static constexpr size_t slotAlignment() noexcept
+	{
+		return alignof( Slot );
+	}
+
 private:
-	std::unique_ptr<T[]> buf;
+	// Slots sit on their own cache lines, so the producer filling one slot
+	// never invalidates the line the consumer is reading, and aligned SIMD
+	// loads of an item are always legal
+	static constexpr size_t SLOT_ALIGN = 64;
+	struct alignas( SLOT_ALIGN ) Slot
+	{
+		T item;
+	};
+	AlignedArray<Slot> buf;
 	size_t max_size = 0;
 	mutable std::mutex buf_mutex;
 	bool full = false;
@@ -96,7 +125,7 @@ private:
 
 template <typename T>
 RingBuffer<T>::RingBuffer(size_t size, int max_timeout) :
-	buf(make_unique<T[]>(size)),
+	buf(makeAlignedArray<Slot, SLOT_ALIGN>(size)),
 	max_size(size),
 	adder(0),
 	remover(0),
@@ -163,7 +192,7 @@ std::optional<bool> RingBuffer<T>::put(T item)
 		return std::nullopt;
 	}
 
-	buf[adder] = item;	// insert item
+	buf[adder].item = item;	// insert item
 
 	adder = (adder + 1) % max_size;	// increment adder
 	full = (adder == remover);
@@ -177,7 +206,7 @@ void RingBuffer<T>::putUnconditional(T item)
 {
 	lock_guard<mutex> lock1(buf_mutex);
 
-	buf[adder] = item;	// insert item
+	buf[adder].item = item;	// insert item
 
 	if (full)
 	{
@@ -199,7 +228,7 @@ std::optional<T> RingBuffer<T>::get()
 		return std::nullopt;
 	}
 
-	auto response = buf[remover];
+	auto response = buf[remover].item;
 
 	remover = (remover + 1) % max_size;
 	full = false;
@@ -217,6 +246,6 @@ std::optional<T> RingBuffer<T>::peek()
 		return std::nullopt;
 	}
 
-	return buf[ remover ];
+	return buf[ remover ].item;
 }
 
@@ -0,0 +1,111 @@
+// test_main.c
+#include "thread_pool.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <threads.h>
+
+#define TASKS        1000
+#define CALLERS      3
+#define ROUNDS       200
+
+typedef struct {
+    uint32_t hits[TASKS];
+    uint32_t spin;          // Extra work for the first indices, so the split is uneven
+} job_t;
+
+static volatile uint64_t sink;
+
+static void count_task( void* arg, uint32_t index )
+{
+    job_t* job = (job_t*)arg;
+    uint64_t sum = 0;
+    uint32_t spin = index < TASKS / 8 ? job->spin : 0;
+    for( uint32_t i = 0; i < spin; i++ )
+    {
+        sum += i * index;
+    }
+    sink += sum;
+    __atomic_add_fetch( &job->hits[index], 1, __ATOMIC_RELAXED );
+}
+
+static void check_once( job_t* job, uint32_t count )
+{
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        assert( job->hits[i] == 1 );
+    }
+    for( uint32_t i = count; i < TASKS; i++ )
+    {
+        assert( job->hits[i] == 0 );
+    }
+}
+
+typedef struct {
+    thread_pool_t* pool;
+    uint32_t seed;
+} caller_t;
+
+static int caller( void* arg )
+{
+    caller_t* c = (caller_t*)arg;
+    static _Thread_local job_t job;
+    for( int r = 0; r < ROUNDS; r++ )
+    {
+        uint32_t count = 1 + ( c->seed * 2654435761u + r * 40503u ) % TASKS;
+        memset( &job, 0, sizeof( job ) );
+        job.spin = 2000;
+        thread_pool_parallel_for( c->pool, count, count_task, &job );
+        check_once( &job, count );
+    }
+    return 0;
+}
+
+int main()
+{
+    thread_pool_t* pool = thread_pool_create( 4 );
+    assert( pool );
+    static job_t job;
+
+    // 1. Every index runs exactly once, including the single-index and empty cases
+    uint32_t counts[] = { 0, 1, 2, 3, TASKS };
+    for( size_t i = 0; i < sizeof( counts ) / sizeof( counts[0] ); i++ )
+    {
+        memset( &job, 0, sizeof( job ) );
+        thread_pool_parallel_for( pool, counts[i], count_task, &job );
+        check_once( &job, counts[i] );
+    }
+    printf( "Test 1 passed: each index runs once\n" );
+
+    // 2. Uneven work gets stolen: the slow first indices should not all land on one worker
+    memset( &job, 0, sizeof( job ) );
+    job.spin = 200000;
+    thread_pool_parallel_for( pool, TASKS, count_task, &job );
+    check_once( &job, TASKS );
+    uint64_t stolen = 0;
+    for( uint32_t i = 0; i < pool->worker_count; i++ )
+    {
+        stolen += pool->workers[i].stolen;
+    }
+    assert( stolen > 0 );
+    printf( "Test 2 passed: %lu ranges stolen\n", (unsigned long)stolen );
+
+    // 3. Several threads submitting at once, as the ISP workers do
+    thrd_t threads[CALLERS];
+    caller_t callers[CALLERS];
+    for( int i = 0; i < CALLERS; i++ )
+    {
+        callers[i].pool = pool;
+        callers[i].seed = i + 1;
+        thrd_create( &threads[i], caller, &callers[i] );
+    }
+    for( int i = 0; i < CALLERS; i++ )
+    {
+        thrd_join( threads[i], NULL );
+    }
+    printf( "Test 3 passed: %d concurrent callers x %d rounds\n", CALLERS, ROUNDS );
+
+    thread_pool_print_stats( pool );
+    thread_pool_destroy( pool );
+    return 0;
+}
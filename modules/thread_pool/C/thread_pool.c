@@ -0,0 +1,354 @@
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TP_SPIN_ROUNDS 64    // Failed steal sweeps before a worker sleeps
+
+struct tp_group {
+    tp_task_fn fn;
+    void* arg;
+    uint32_t count;
+    uint32_t pending;           // Indices not yet run
+    bool done;                  // Set under lock once pending hits zero
+    tp_group_t* next;           // Injection list link
+    mtx_t lock;
+    cnd_t finished;
+};
+
+// --- Chase-Lev deque ---
+// Slots are read and written with relaxed atomics; a thief may read a slot
+// the owner is reusing, but then its CAS on top fails and the value is dropped.
+
+static void slot_store( tp_range_t* slot, const tp_range_t* range )
+{
+    __atomic_store_n( &slot->group, range->group, __ATOMIC_RELAXED );
+    __atomic_store_n( &slot->begin, range->begin, __ATOMIC_RELAXED );
+    __atomic_store_n( &slot->end, range->end, __ATOMIC_RELAXED );
+}
+
+static void slot_load( tp_range_t* slot, tp_range_t* range )
+{
+    range->group = __atomic_load_n( &slot->group, __ATOMIC_RELAXED );
+    range->begin = __atomic_load_n( &slot->begin, __ATOMIC_RELAXED );
+    range->end = __atomic_load_n( &slot->end, __ATOMIC_RELAXED );
+}
+
+// Owner only. Returns false when the deque is full.
+static bool deque_push( tp_worker_t* w, const tp_range_t* range )
+{
+    int64_t b = __atomic_load_n( &w->bottom, __ATOMIC_RELAXED );
+    int64_t t = __atomic_load_n( &w->top, __ATOMIC_ACQUIRE );
+    if( b - t >= TP_DEQUE_CAPACITY )
+    {
+        return false;
+    }
+    slot_store( &w->slots[b & ( TP_DEQUE_CAPACITY - 1 )], range );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+    __atomic_store_n( &w->bottom, b + 1, __ATOMIC_RELAXED );
+    return true;
+}
+
+// Owner only, newest first
+static bool deque_take( tp_worker_t* w, tp_range_t* range )
+{
+    int64_t b = __atomic_load_n( &w->bottom, __ATOMIC_RELAXED ) - 1;
+    __atomic_store_n( &w->bottom, b, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    int64_t t = __atomic_load_n( &w->top, __ATOMIC_RELAXED );
+    if( t > b )
+    {
+        __atomic_store_n( &w->bottom, b + 1, __ATOMIC_RELAXED );
+        return false;
+    }
+    slot_load( &w->slots[b & ( TP_DEQUE_CAPACITY - 1 )], range );
+    if( t == b )
+    {
+        // Last entry: race the thieves for it
+        bool won = __atomic_compare_exchange_n( &w->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED );
+        __atomic_store_n( &w->bottom, b + 1, __ATOMIC_RELAXED );
+        return won;
+    }
+    return true;
+}
+
+// Any thread, oldest (largest) first
+static bool deque_steal( tp_worker_t* w, tp_range_t* range )
+{
+    int64_t t = __atomic_load_n( &w->top, __ATOMIC_ACQUIRE );
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    int64_t b = __atomic_load_n( &w->bottom, __ATOMIC_ACQUIRE );
+    if( t >= b )
+    {
+        return false;
+    }
+    slot_load( &w->slots[t & ( TP_DEQUE_CAPACITY - 1 )], range );
+    return __atomic_compare_exchange_n( &w->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED );
+}
+
+static bool deque_empty( tp_worker_t* w )
+{
+    return __atomic_load_n( &w->top, __ATOMIC_ACQUIRE ) >= __atomic_load_n( &w->bottom, __ATOMIC_ACQUIRE );
+}
+
+// --- Scheduling ---
+
+static void wake_one( thread_pool_t* pool )
+{
+    // Pairs with the fence in worker_sleep: either the sleeper sees the new
+    // work, or we see it counted as idle and signal it
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    if( __atomic_load_n( &pool->idle, __ATOMIC_RELAXED ) > 0 )
+    {
+        mtx_lock( &pool->lock );
+        cnd_signal( &pool->wake );
+        mtx_unlock( &pool->lock );
+    }
+}
+
+static bool inject_pop( thread_pool_t* pool, tp_range_t* range )
+{
+    if( !__atomic_load_n( &pool->inject_head, __ATOMIC_ACQUIRE ) )
+    {
+        return false;
+    }
+    mtx_lock( &pool->lock );
+    tp_group_t* group = pool->inject_head;
+    if( group )
+    {
+        pool->inject_head = group->next;
+    }
+    mtx_unlock( &pool->lock );
+    if( !group )
+    {
+        return false;
+    }
+    range->group = group;
+    range->begin = 0;
+    range->end = group->count;
+    return true;
+}
+
+static bool steal_any( tp_worker_t* self, tp_range_t* range )
+{
+    thread_pool_t* pool = self->pool;
+    // xorshift so thieves do not all start on the same victim
+    self->rng ^= self->rng << 13;
+    self->rng ^= self->rng >> 17;
+    self->rng ^= self->rng << 5;
+    uint32_t start = self->rng % pool->worker_count;
+    for( uint32_t i = 0; i < pool->worker_count; i++ )
+    {
+        tp_worker_t* victim = &pool->workers[( start + i ) % pool->worker_count];
+        if( victim != self && deque_steal( victim, range ) )
+        {
+            __atomic_add_fetch( &self->stolen, 1, __ATOMIC_RELAXED );
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool work_available( thread_pool_t* pool )
+{
+    if( __atomic_load_n( &pool->inject_head, __ATOMIC_ACQUIRE ) )
+    {
+        return true;
+    }
+    for( uint32_t i = 0; i < pool->worker_count; i++ )
+    {
+        if( !deque_empty( &pool->workers[i] ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void run_range( tp_worker_t* self, tp_range_t range )
+{
+    // Keep the lower half, offer the upper half to thieves, until one index is left.
+    // If the deque is full the rest simply runs here.
+    while( range.end - range.begin > 1 )
+    {
+        uint32_t mid = range.begin + ( range.end - range.begin ) / 2;
+        tp_range_t upper = { range.group, mid, range.end };
+        if( !deque_push( self, &upper ) )
+        {
+            break;
+        }
+        range.end = mid;
+        wake_one( self->pool );
+    }
+    tp_group_t* group = range.group;
+    for( uint32_t i = range.begin; i < range.end; i++ )
+    {
+        group->fn( group->arg, i );
+    }
+    __atomic_add_fetch( &self->executed, range.end - range.begin, __ATOMIC_RELAXED );
+    if( __atomic_sub_fetch( &group->pending, range.end - range.begin, __ATOMIC_ACQ_REL ) == 0 )
+    {
+        // The group lives on the waiter's stack and goes away as soon as it
+        // sees done, so done is only published under the lock
+        mtx_lock( &group->lock );
+        group->done = true;
+        cnd_signal( &group->finished );
+        mtx_unlock( &group->lock );
+    }
+}
+
+static void worker_sleep( thread_pool_t* pool )
+{
+    mtx_lock( &pool->lock );
+    __atomic_add_fetch( &pool->idle, 1, __ATOMIC_SEQ_CST );
+    // Pairs with the fence in wake_one: orders the idle count before the
+    // work_available loads, which an RMW alone does not do in C11
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    while( !__atomic_load_n( &pool->stop, __ATOMIC_ACQUIRE ) && !work_available( pool ) )
+    {
+        cnd_wait( &pool->wake, &pool->lock );
+    }
+    __atomic_sub_fetch( &pool->idle, 1, __ATOMIC_SEQ_CST );
+    mtx_unlock( &pool->lock );
+}
+
+static int worker_loop( void* arg )
+{
+    tp_worker_t* self = (tp_worker_t*)arg;
+    thread_pool_t* pool = self->pool;
+    uint32_t misses = 0;
+    while( !__atomic_load_n( &pool->stop, __ATOMIC_ACQUIRE ) )
+    {
+        tp_range_t range;
+        if( deque_take( self, &range ) || inject_pop( pool, &range ) || steal_any( self, &range ) )
+        {
+            misses = 0;
+            run_range( self, range );
+        }
+        else if( ++misses < TP_SPIN_ROUNDS )
+        {
+            thrd_yield();
+        }
+        else
+        {
+            misses = 0;
+            worker_sleep( pool );
+        }
+    }
+    return 0;
+}
+
+// --- Public API ---
+
+// Stops and joins the first 'started' workers, then frees the pool
+static void shutdown_workers( thread_pool_t* pool, uint32_t started )
+{
+    mtx_lock( &pool->lock );
+    __atomic_store_n( &pool->stop, true, __ATOMIC_RELEASE );
+    cnd_broadcast( &pool->wake );
+    mtx_unlock( &pool->lock );
+    for( uint32_t i = 0; i < started; i++ )
+    {
+        thrd_join( pool->workers[i].thread, NULL );
+    }
+    cnd_destroy( &pool->wake );
+    mtx_destroy( &pool->lock );
+    free( pool->workers );
+    free( pool );
+}
+
+thread_pool_t* thread_pool_create( uint32_t worker_count )
+{
+    if( worker_count == 0 || worker_count > TP_MAX_WORKERS )
+    {
+        printf( "Thread pool needs 1 to %d workers\n", TP_MAX_WORKERS );
+        return NULL;
+    }
+    thread_pool_t* pool = calloc( 1, sizeof( thread_pool_t ) );
+    if( !pool )
+    {
+        return NULL;
+    }
+    // Deques carry _Alignas( 64 ) members, so plain malloc is not enough
+    pool->workers = aligned_alloc( 64, sizeof( tp_worker_t ) * worker_count );
+    if( !pool->workers )
+    {
+        free( pool );
+        return NULL;
+    }
+    mtx_init( &pool->lock, mtx_plain );
+    cnd_init( &pool->wake );
+    for( uint32_t i = 0; i < worker_count; i++ )
+    {
+        tp_worker_t* w = &pool->workers[i];
+        w->top = 0;
+        w->bottom = 0;
+        w->pool = pool;
+        w->index = i;
+        w->rng = 0x9E3779B9u * ( i + 1 );
+        w->executed = 0;
+        w->stolen = 0;
+    }
+    // Workers index each other from the start, so the count is fixed before any runs
+    pool->worker_count = worker_count;
+    for( uint32_t i = 0; i < worker_count; i++ )
+    {
+        if( thrd_create( &pool->workers[i].thread, worker_loop, &pool->workers[i] ) != thrd_success )
+        {
+            printf( "Thread pool worker %u failed to start\n", i );
+            shutdown_workers( pool, i );
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void thread_pool_destroy( thread_pool_t* pool )
+{
+    if( !pool )
+    {
+        return;
+    }
+    shutdown_workers( pool, pool->worker_count );
+}
+
+void thread_pool_parallel_for( thread_pool_t* pool, uint32_t count, tp_task_fn fn, void* arg )
+{
+    if( count == 0 )
+    {
+        return;
+    }
+    tp_group_t group;
+    group.fn = fn;
+    group.arg = arg;
+    group.count = count;
+    group.pending = count;
+    group.done = false;
+    mtx_init( &group.lock, mtx_plain );
+    cnd_init( &group.finished );
+
+    mtx_lock( &pool->lock );
+    group.next = pool->inject_head;
+    __atomic_store_n( &pool->inject_head, &group, __ATOMIC_RELEASE );
+    cnd_signal( &pool->wake );
+    mtx_unlock( &pool->lock );
+
+    mtx_lock( &group.lock );
+    while( !group.done )
+    {
+        cnd_wait( &group.finished, &group.lock );
+    }
+    mtx_unlock( &group.lock );
+    cnd_destroy( &group.finished );
+    mtx_destroy( &group.lock );
+}
+
+void thread_pool_print_stats( thread_pool_t* pool )
+{
+    for( uint32_t i = 0; i < pool->worker_count; i++ )
+    {
+        tp_worker_t* w = &pool->workers[i];
+        printf( "[Pool] Worker %u: %lu tasks run, %lu ranges stolen\n", i,
+                (unsigned long)__atomic_load_n( &w->executed, __ATOMIC_RELAXED ),
+                (unsigned long)__atomic_load_n( &w->stolen, __ATOMIC_RELAXED ) );
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <threads.h>
+
+#define TP_MAX_WORKERS     16
+#define TP_DEQUE_CAPACITY  256   // Power of 2; ranges are split in halves, so depth stays near log2(count)
+
+typedef void (*tp_task_fn)( void* arg, uint32_t index );
+
+typedef struct tp_group tp_group_t;
+
+// A contiguous run of indices of one parallel_for
+typedef struct {
+    tp_group_t* group;
+    uint32_t begin;
+    uint32_t end;
+} tp_range_t;
+
+// Chase-Lev deque: the owner pushes and takes at the bottom, thieves take
+// from the top with a CAS. top and bottom sit on their own cache lines so
+// the owner's pushes do not bounce the line thieves spin on.
+typedef struct {
+    _Alignas( 64 ) int64_t top;
+    _Alignas( 64 ) int64_t bottom;
+    tp_range_t slots[TP_DEQUE_CAPACITY];
+
+    struct thread_pool* pool;
+    uint32_t index;
+    uint32_t rng;               // Victim selection
+    thrd_t thread;
+    uint64_t executed;          // Indices run by this worker
+    uint64_t stolen;            // Ranges taken from other workers
+} tp_worker_t;
+
+typedef struct thread_pool {
+    tp_worker_t* workers;
+    uint32_t worker_count;
+    bool stop;
+
+    // parallel_for callers are not workers and cannot push to a deque;
+    // their root ranges wait here until a worker picks them up
+    tp_group_t* inject_head;
+    uint32_t idle;              // Workers asleep on wake
+    mtx_t lock;
+    cnd_t wake;
+} thread_pool_t;
+
+thread_pool_t* thread_pool_create( uint32_t worker_count );
+void thread_pool_destroy( thread_pool_t* pool );
+
+// Calls fn( arg, i ) for every i in [0, count) on the pool's workers and
+// returns when all of them have finished. Any thread may call it, several
+// at once; the calling thread blocks rather than running indices itself.
+// Workers split the range in halves as they go, so idle workers steal big
+// pieces first and each index runs exactly once.
+void thread_pool_parallel_for( thread_pool_t* pool, uint32_t count, tp_task_fn fn, void* arg );
+
+// Per-worker indices run and ranges stolen, for checking the load spread
+void thread_pool_print_stats( thread_pool_t* pool );
+
+#endif
@@ -0,0 +1,258 @@
+#include "dma_engine.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "aligned_malloc.h"
+#include "numa_place.h"
+#include "sensor_fill.h"
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void map_replay(dma_engine_t* dma, const char* path)
+{
+    int fd = open( path, O_RDONLY );
+    if( fd < 0 )
+    {
+        printf("[DMA] Cannot open replay file %s\n", path);
+        return;
+    }
+    struct stat st;
+    if( fstat( fd, &st ) != 0 || st.st_size == 0 )
+    {
+        close( fd );
+        printf("[DMA] Replay file %s is empty\n", path);
+        return;
+    }
+    void* base = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );    // the mapping keeps the file referenced
+    if( base == MAP_FAILED )
+    {
+        printf("[DMA] Cannot map replay file %s\n", path);
+        return;
+    }
+    // Frames are read front to back once per pass
+    madvise( base, st.st_size, MADV_SEQUENTIAL );
+    dma->replay = base;
+    dma->replay_size = st.st_size;
+}
+
+// Copies transfer->size bytes of the replay file from replay_offset, wrapping at the end
+static dma_status_t run_replay(dma_engine_t* dma, dma_transfer_t* transfer)
+{
+    if( !dma->replay )
+    {
+        return DMA_STATUS_ERROR;
+    }
+    uint8_t* dst = transfer->dst;
+    size_t offset = transfer->replay_offset % dma->replay_size;
+    size_t left = transfer->size;
+    while( left > 0 )
+    {
+        size_t chunk = dma->replay_size - offset < left ? dma->replay_size - offset : left;
+        memcpy( dst, dma->replay + offset, chunk );
+        dst += chunk;
+        left -= chunk;
+        offset = 0;
+    }
+    return DMA_STATUS_DONE;
+}
+
+static int engine_thread_loop(void* arg)
+{
+    dma_engine_t* dma = (dma_engine_t*)arg;
+    numa_bind_thread( dma->numa_node );
+    mtx_lock( &dma->lock );
+    uint32_t index = dma->started++;
+    while( true )
+    {
+        while( !dma->sq_head && !dma->stop )
+        {
+            cnd_wait( &dma->work, &dma->lock );
+        }
+        if( !dma->sq_head )
+        {
+            break;  // Stopping and the queue is drained
+        }
+        dma_transfer_t* transfer = dma->sq_head;
+        dma->sq_head = transfer->next;
+        if( !dma->sq_head )
+        {
+            dma->sq_tail = NULL;
+        }
+        mtx_unlock( &dma->lock );
+
+        uint64_t start_ns = now_ns();
+        alloc_hot_path_enter();
+        dma_status_t status = DMA_STATUS_DONE;
+        if( transfer->source == DMA_SOURCE_REPLAY )
+        {
+            status = run_replay( dma, transfer );
+        }
+        else
+        {
+            // Streaming stores: the frame goes to memory, not into the caches the ISP is using
+            sensor_fill( transfer->dst, transfer->size, transfer->seed, transfer->noise_seed,
+                         transfer->noise_bits, true );
+        }
+        alloc_hot_path_exit();
+        transfer->status = status;
+        transfer->engine = index;
+        transfer->done_ns = now_ns();
+
+        mtx_lock( &dma->lock );
+        dma->busy_ns[index] += transfer->done_ns - start_ns;
+        dma->completed++;
+        dma->errors += status == DMA_STATUS_ERROR;
+        // in_flight caps submissions at the ring size, so this slot is free
+        dma->cq[( dma->cq_head + dma->cq_count ) % DMA_RING_SIZE] = transfer;
+        dma->cq_count++;
+        cnd_signal( &dma->done );
+    }
+    mtx_unlock( &dma->lock );
+    return 0;
+}
+
+dma_engine_t* dma_engine_create(uint32_t engine_count, int numa_node, const char* replay_path)
+{
+    if( engine_count == 0 || engine_count > DMA_MAX_ENGINES )
+    {
+        printf("[DMA] Engine count must be 1 to %d\n", DMA_MAX_ENGINES);
+        return NULL;
+    }
+    // Holds the submission and completion rings, so it counts as a queue
+    dma_engine_t* dma = aligned_malloc_tagged( sizeof(dma_engine_t), _Alignof( dma_engine_t ), ALLOC_TAG_QUEUE );
+    if( !dma )
+    {
+        return NULL;
+    }
+    memset( dma, 0, sizeof(dma_engine_t) );
+    dma->numa_node = numa_node;
+    if( replay_path )
+    {
+        map_replay( dma, replay_path );
+    }
+    mtx_init( &dma->lock, mtx_plain );
+    cnd_init( &dma->work );
+    cnd_init( &dma->done );
+    for( uint32_t i = 0; i < engine_count; i++ )
+    {
+        if( thrd_create( &dma->engines[i], engine_thread_loop, dma ) != thrd_success )
+        {
+            // Keep the engines that started
+            printf("[DMA] Only %u of %u engines started\n", i, engine_count);
+            break;
+        }
+        dma->engine_count++;
+    }
+    if( dma->engine_count == 0 )
+    {
+        dma_engine_destroy( dma );
+        return NULL;
+    }
+    return dma;
+}
+
+void dma_engine_destroy(dma_engine_t* dma)
+{
+    if( !dma )
+    {
+        return;
+    }
+    mtx_lock( &dma->lock );
+    dma->stop = true;
+    cnd_broadcast( &dma->work );
+    mtx_unlock( &dma->lock );
+    for( uint32_t i = 0; i < dma->engine_count; i++ )
+    {
+        thrd_join( dma->engines[i], NULL );
+    }
+
+    printf("[DMA] %u transfers, %u errors, up to %u in flight\n", dma->submitted, dma->errors, dma->max_in_flight);
+    for( uint32_t i = 0; i < dma->engine_count; i++ )
+    {
+        printf("[DMA] Engine %u busy %.1f ms\n", i, dma->busy_ns[i] / 1e6);
+    }
+    if( dma->replay )
+    {
+        munmap( (void*)dma->replay, dma->replay_size );
+    }
+    cnd_destroy( &dma->done );
+    cnd_destroy( &dma->work );
+    mtx_destroy( &dma->lock );
+    free_aligned( dma );
+}
+
+bool dma_submit(dma_engine_t* dma, dma_transfer_t* transfer)
+{
+    transfer->status = DMA_STATUS_PENDING;
+    transfer->next = NULL;
+    transfer->submit_ns = now_ns();
+    mtx_lock( &dma->lock );
+    if( dma->in_flight == DMA_RING_SIZE || dma->stop )
+    {
+        mtx_unlock( &dma->lock );
+        return false;
+    }
+    if( dma->sq_tail )
+    {
+        dma->sq_tail->next = transfer;
+    }
+    else
+    {
+        dma->sq_head = transfer;
+    }
+    dma->sq_tail = transfer;
+    dma->in_flight++;
+    dma->submitted++;
+    if( dma->in_flight > dma->max_in_flight )
+    {
+        dma->max_in_flight = dma->in_flight;
+    }
+    cnd_signal( &dma->work );
+    mtx_unlock( &dma->lock );
+    return true;
+}
+
+dma_transfer_t* dma_reap(dma_engine_t* dma, uint64_t deadline_ns)
+{
+    mtx_lock( &dma->lock );
+    while( dma->cq_count == 0 )
+    {
+        uint64_t now = now_ns();
+        if( now >= deadline_ns )
+        {
+            mtx_unlock( &dma->lock );
+            return NULL;
+        }
+        // C11 timed waits take a TIME_UTC deadline; convert from the monotonic one
+        struct timespec until;
+        timespec_get( &until, TIME_UTC );
+        uint64_t wait_ns = deadline_ns - now;
+        until.tv_sec += wait_ns / 1000000000ULL;
+        until.tv_nsec += wait_ns % 1000000000ULL;
+        if( until.tv_nsec >= 1000000000L )
+        {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        cnd_timedwait( &dma->done, &dma->lock, &until );
+    }
+    dma_transfer_t* transfer = dma->cq[dma->cq_head];
+    dma->cq_head = ( dma->cq_head + 1 ) % DMA_RING_SIZE;
+    dma->cq_count--;
+    dma->in_flight--;
+    mtx_unlock( &dma->lock );
+    return transfer;
+}
@@ -0,0 +1,93 @@
+#ifndef DMA_ENGINE_H
+#define DMA_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <threads.h>
+
+#define DMA_MAX_ENGINES  4
+#define DMA_RING_SIZE    16     // Transfers in flight, submitted or completed but not yet reaped
+
+typedef enum {
+    DMA_SOURCE_PATTERN,         // Synthetic gradient (+ noise) from sensor_fill
+    DMA_SOURCE_REPLAY           // Bytes from the replay file
+} dma_source_t;
+
+typedef enum {
+    DMA_STATUS_PENDING,
+    DMA_STATUS_DONE,
+    DMA_STATUS_ERROR            // Replay source missing or too short
+} dma_status_t;
+
+// --- One transfer: descriptor in, completion out ---
+// Owned by the submitter (a frame embeds its own), so the engine never
+// allocates; it only links and fills in the completion fields.
+typedef struct dma_transfer {
+    // Descriptor
+    void* dst;
+    size_t size;
+    dma_source_t source;
+    uint8_t seed;               // Pattern: gradient start
+    uint32_t noise_seed;        // Pattern: noise stream seed
+    uint32_t noise_bits;        // Pattern: 0 for no noise
+    uint64_t replay_offset;     // Replay: byte offset, wrapped to the file size
+    void* cookie;               // Handed back untouched with the completion
+
+    // Completion, valid once reaped
+    dma_status_t status;
+    uint32_t engine;            // Engine that ran it
+    uint64_t submit_ns;
+    uint64_t done_ns;
+
+    struct dma_transfer* next;  // Submission queue link
+} dma_transfer_t;
+
+// --- Simulated DMA controller ---
+// Engine threads take descriptors in submission order and fill the
+// destination while the submitter carries on; finished transfers are posted
+// to a completion ring that the submitter drains with dma_reap. With more
+// than one engine, completions can arrive out of submission order.
+typedef struct {
+    dma_transfer_t* sq_head;    // Submission queue, FIFO
+    dma_transfer_t* sq_tail;
+    dma_transfer_t* cq[DMA_RING_SIZE];  // Completion ring
+    uint32_t cq_head;
+    uint32_t cq_count;
+    uint32_t in_flight;         // Submitted and not yet reaped, at most DMA_RING_SIZE
+    bool stop;
+    mtx_t lock;
+    cnd_t work;                 // Engines wait here for descriptors
+    cnd_t done;                 // dma_reap waits here for completions
+
+    thrd_t engines[DMA_MAX_ENGINES];
+    uint32_t engine_count;      // Threads created
+    uint32_t started;           // Engine indices handed out, under lock
+    int numa_node;
+
+    const uint8_t* replay;      // Mapped replay file, NULL if none
+    size_t replay_size;
+
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t errors;
+    uint32_t max_in_flight;
+    uint64_t busy_ns[DMA_MAX_ENGINES];
+} dma_engine_t;
+
+// Starts engine_count engine threads on numa_node (NUMA_NODE_ANY for no
+// binding). replay_path may be NULL; if it cannot be mapped, replay
+// transfers complete with DMA_STATUS_ERROR. NULL on failure.
+dma_engine_t* dma_engine_create(uint32_t engine_count, int numa_node, const char* replay_path);
+
+// Stops the engines after the queued transfers finish; unreaped completions are dropped
+void dma_engine_destroy(dma_engine_t* dma);
+
+// Queues a transfer. False when DMA_RING_SIZE transfers are already in flight.
+bool dma_submit(dma_engine_t* dma, dma_transfer_t* transfer);
+
+// Next completed transfer, waiting until deadline_ns (CLOCK_MONOTONIC) at the
+// latest; NULL if none finished by then. Pass 0 to poll.
+dma_transfer_t* dma_reap(dma_engine_t* dma, uint64_t deadline_ns);
+
+#endif
@@ -0,0 +1,98 @@
+#include "frame_reorder.h"
+
+#include <string.h>
+
+int frame_reorder_init(frame_reorder_t* ro, void (*deliver)(void* item, void* ctx), void* ctx)
+{
+    memset( ro, 0, sizeof( *ro ) );
+    ro->deliver = deliver;
+    ro->ctx = ctx;
+    return mtx_init( &ro->lock, mtx_plain ) == thrd_success ? 0 : -1;
+}
+
+void frame_reorder_destroy(frame_reorder_t* ro)
+{
+    mtx_destroy( &ro->lock );
+}
+
+// Delivers every resolved sequence from next_seq on. Caller holds the lock.
+static void drain(frame_reorder_t* ro)
+{
+    for( ;; )
+    {
+        reorder_slot_t* slot = &ro->slots[ro->next_seq & ( REORDER_WINDOW - 1 )];
+        if( !slot->resolved || slot->seq != ro->next_seq )
+        {
+            return;
+        }
+        if( slot->item )
+        {
+            ro->deliver( slot->item, ro->ctx );
+            ro->delivered++;
+        }
+        slot->resolved = false;
+        slot->item = NULL;
+        ro->next_seq++;
+    }
+}
+
+// Makes room for 'seq' when it is a full window ahead. Sequences pushed out
+// are given up on: whatever already completed is delivered, anything still
+// in a worker is delivered late when it arrives. Caller holds the lock.
+static void make_room(frame_reorder_t* ro, uint32_t seq)
+{
+    while( seq - ro->next_seq >= REORDER_WINDOW )
+    {
+        reorder_slot_t* slot = &ro->slots[ro->next_seq & ( REORDER_WINDOW - 1 )];
+        if( slot->resolved && slot->seq == ro->next_seq && slot->item )
+        {
+            ro->deliver( slot->item, ro->ctx );
+            ro->delivered++;
+        }
+        slot->resolved = false;
+        slot->item = NULL;
+        ro->next_seq++;
+        drain( ro );
+    }
+}
+
+static void resolve(frame_reorder_t* ro, uint32_t seq, void* item)
+{
+    mtx_lock( &ro->lock );
+    // Sequence arithmetic is unsigned, so 'behind' also holds across wrap-around
+    if( (int32_t)( seq - ro->next_seq ) < 0 )
+    {
+        if( item )
+        {
+            ro->deliver( item, ro->ctx );
+            ro->late++;
+        }
+        mtx_unlock( &ro->lock );
+        return;
+    }
+    make_room( ro, seq );
+    reorder_slot_t* slot = &ro->slots[seq & ( REORDER_WINDOW - 1 )];
+    slot->seq = seq;
+    slot->item = item;
+    slot->resolved = true;
+    if( !item )
+    {
+        ro->skipped++;
+    }
+    if( seq - ro->next_seq + 1 > ro->max_pending )
+    {
+        ro->max_pending = seq - ro->next_seq + 1;
+    }
+    drain( ro );
+    mtx_unlock( &ro->lock );
+}
+
+void frame_reorder_complete(frame_reorder_t* ro, uint32_t seq, void* item)
+{
+    resolve( ro, seq, item );
+}
+
+void frame_reorder_skip(frame_reorder_t* ro, uint32_t seq)
+{
+    resolve( ro, seq, NULL );
+}
@@ -0,0 +1,44 @@
+#ifndef FRAME_REORDER_H
+#define FRAME_REORDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <threads.h>
+
+#define REORDER_WINDOW 64   // Power of 2, sequences tracked ahead of the next one due
+
+// --- In-order delivery for parallel ISP workers ---
+// Workers finish frames in any order; each completed frame is parked by its
+// sensor sequence number and handed to 'deliver' strictly in sequence order.
+// A sequence that will never complete (frame recycled before processing)
+// must be skipped, or delivery would wait for it forever.
+typedef struct {
+    void* item;
+    uint32_t seq;
+    bool resolved;          // Completed or skipped
+} reorder_slot_t;
+
+typedef struct {
+    reorder_slot_t slots[REORDER_WINDOW];
+    uint32_t next_seq;      // Next sequence to deliver
+    void (*deliver)(void* item, void* ctx);
+    void* ctx;
+    mtx_t lock;
+
+    uint32_t delivered;
+    uint32_t skipped;
+    uint32_t late;          // Completed after the window was forced past them
+    uint32_t max_pending;   // Deepest the window got, for sizing it
+} frame_reorder_t;
+
+// deliver runs under the reorder lock, from whichever thread completed the frame
+int frame_reorder_init(frame_reorder_t* ro, void (*deliver)(void* item, void* ctx), void* ctx);
+void frame_reorder_destroy(frame_reorder_t* ro);
+
+// A worker finished the frame with this sequence
+void frame_reorder_complete(frame_reorder_t* ro, uint32_t seq, void* item);
+
+// The frame with this sequence was dropped and will never complete
+void frame_reorder_skip(frame_reorder_t* ro, uint32_t seq);
+
+#endif
@@ -0,0 +1,181 @@
+#include "lens_db.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t align_up(uint64_t value, uint64_t alignment)
+{
+    return ( value + alignment - 1 ) & ~( alignment - 1 );
+}
+
+// True when count entries of entry_size bytes starting at offset lie inside
+// the file. Written so that neither the multiply nor the add can wrap on a
+// corrupt header.
+static bool table_fits(uint64_t offset, uint64_t count, uint64_t entry_size, uint64_t length)
+{
+    return offset <= length && count <= ( length - offset ) / entry_size;
+}
+
+lens_db_t* lens_db_open(const char* path)
+{
+    int fd = open( path, O_RDONLY );
+    if( fd < 0 )
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    if( fstat( fd, &st ) != 0 || (size_t)st.st_size < sizeof(LensDbHeader_t) )
+    {
+        close( fd );
+        return NULL;
+    }
+
+    void* base = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );    // the mapping keeps the file referenced
+    if( base == MAP_FAILED )
+    {
+        return NULL;
+    }
+
+    const LensDbHeader_t* header = base;
+    uint64_t length = st.st_size;
+    uint64_t count = header->count;
+    if( header->magic != LENS_DB_MAGIC || header->version != LENS_DB_VERSION ||
+        header->profile_stride != sizeof(LensProfile_t) ||
+        header->profile_offset % LENS_CACHE_LINE != 0 ||
+        !table_fits( header->index_offset, count, sizeof(LensDbIndexEntry_t), length ) ||
+        !table_fits( header->profile_offset, count, sizeof(LensProfile_t), length ) ||
+        !table_fits( header->descriptor_offset, count, sizeof(LensDescriptor_t), length ) )
+    {
+        printf("[LensDB] %s is not a valid calibration database\n", path);
+        munmap( base, st.st_size );
+        return NULL;
+    }
+
+    lens_db_t* db = malloc( sizeof(lens_db_t) );
+    if( !db )
+    {
+        munmap( base, st.st_size );
+        return NULL;
+    }
+    db->base = base;
+    db->length = st.st_size;
+    db->header = header;
+    db->index = (const LensDbIndexEntry_t*)( db->base + header->index_offset );
+    db->profiles = (const LensProfile_t*)( db->base + header->profile_offset );
+    db->descriptors = (const LensDescriptor_t*)( db->base + header->descriptor_offset );
+
+    // Lookups jump around the file, don't waste readahead on them
+    madvise( base, st.st_size, MADV_RANDOM );
+    return db;
+}
+
+void lens_db_close(lens_db_t* db)
+{
+    if( !db )
+    {
+        return;
+    }
+    munmap( (void*)db->base, db->length );
+    free( db );
+}
+
+static const LensDbIndexEntry_t* lens_db_lookup(const lens_db_t* db, uint32_t lens_id)
+{
+    if( !db )
+    {
+        return NULL;
+    }
+    uint32_t lo = 0;
+    uint32_t hi = db->header->count;
+    while( lo < hi )
+    {
+        uint32_t mid = lo + ( hi - lo ) / 2;
+        if( db->index[mid].lens_id < lens_id )
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if( lo < db->header->count && db->index[lo].lens_id == lens_id &&
+        db->index[lo].record < db->header->count )
+    {
+        return &db->index[lo];
+    }
+    return NULL;
+}
+
+const LensProfile_t* lens_db_find(const lens_db_t* db, uint32_t lens_id)
+{
+    const LensDbIndexEntry_t* entry = lens_db_lookup( db, lens_id );
+    return entry ? &db->profiles[entry->record] : NULL;
+}
+
+const LensDescriptor_t* lens_db_find_descriptor(const lens_db_t* db, uint32_t lens_id)
+{
+    const LensDbIndexEntry_t* entry = lens_db_lookup( db, lens_id );
+    return entry ? &db->descriptors[entry->record] : NULL;
+}
+
+int lens_db_owns(const lens_db_t* db, const void* ptr)
+{
+    return db && (const uint8_t*)ptr >= db->base && (const uint8_t*)ptr < db->base + db->length;
+}
+
+static int compare_index_entries(const void* a, const void* b)
+{
+    uint32_t ka = ((const LensDbIndexEntry_t*)a)->lens_id;
+    uint32_t kb = ((const LensDbIndexEntry_t*)b)->lens_id;
+    return ( ka > kb ) - ( ka < kb );
+}
+
+int lens_db_write(const char* path, const LensProfile_t* profiles,
+                  const LensDescriptor_t* descriptors, uint32_t count)
+{
+    LensDbHeader_t header = { 0 };
+    header.magic = LENS_DB_MAGIC;
+    header.version = LENS_DB_VERSION;
+    header.count = count;
+    header.profile_stride = sizeof(LensProfile_t);
+    header.index_offset = sizeof(LensDbHeader_t);
+    header.profile_offset = align_up( header.index_offset + (uint64_t)count * sizeof(LensDbIndexEntry_t),
+                                      LENS_CACHE_LINE );
+    header.descriptor_offset = header.profile_offset + (uint64_t)count * sizeof(LensProfile_t);
+    size_t total = header.descriptor_offset + (uint64_t)count * sizeof(LensDescriptor_t);
+
+    // Build the whole image in memory, then write it in one go
+    uint8_t* image = calloc( 1, total );
+    if( !image )
+    {
+        return -1;
+    }
+    memcpy( image, &header, sizeof(header) );
+    LensDbIndexEntry_t* index = (LensDbIndexEntry_t*)( image + header.index_offset );
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        index[i].lens_id = profiles[i].lens_id;
+        index[i].record = i;
+    }
+    qsort( index, count, sizeof(LensDbIndexEntry_t), compare_index_entries );
+    memcpy( image + header.profile_offset, profiles, (size_t)count * sizeof(LensProfile_t) );
+    memcpy( image + header.descriptor_offset, descriptors, (size_t)count * sizeof(LensDescriptor_t) );
+
+    FILE* file = fopen( path, "wb" );
+    int ok = file && fwrite( image, 1, total, file ) == total;
+    if( file && fclose( file ) != 0 )
+    {
+        ok = 0;
+    }
+    free( image );
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,60 @@
+#ifndef LENS_DB_H
+#define LENS_DB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lens_metadata.h"
+
+// --- On-disk calibration database ---
+// [header][index: count x LensDbIndexEntry_t, sorted by lens_id]
+// [profiles: count x LensProfile_t, 64-byte aligned][descriptors: count x LensDescriptor_t]
+// The file is mmapped read-only and records are used in place, never copied.
+#define LENS_DB_MAGIC     0x42444C4Cu   // "LLDB"
+#define LENS_DB_VERSION   1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t profile_stride;       // sizeof(LensProfile_t) at write time
+    uint64_t index_offset;
+    uint64_t profile_offset;
+    uint64_t descriptor_offset;
+} LensDbHeader_t;
+
+typedef struct {
+    uint32_t lens_id;
+    uint32_t record;               // slot in the profile/descriptor arrays
+} LensDbIndexEntry_t;
+
+typedef struct {
+    const uint8_t* base;
+    size_t length;
+    const LensDbHeader_t* header;
+    const LensDbIndexEntry_t* index;
+    const LensProfile_t* profiles;
+    const LensDescriptor_t* descriptors;
+} lens_db_t;
+
+// Maps and validates a database file, NULL if missing or malformed
+lens_db_t* lens_db_open(const char* path);
+
+// Unmaps the database; pointers returned by lookups become invalid
+void lens_db_close(lens_db_t* db);
+
+// Binary search of the index, returns a pointer into the mapping or NULL
+const LensProfile_t* lens_db_find(const lens_db_t* db, uint32_t lens_id);
+
+// Cold fields for the same lens, NULL if not present
+const LensDescriptor_t* lens_db_find_descriptor(const lens_db_t* db, uint32_t lens_id);
+
+// True if ptr points into the mapping
+int lens_db_owns(const lens_db_t* db, const void* ptr);
+
+// Writes a database; profiles[i] and descriptors[i] describe the same lens.
+// Input order does not matter, the index is sorted here. Returns 0 on success.
+int lens_db_write(const char* path, const LensProfile_t* profiles,
+                  const LensDescriptor_t* descriptors, uint32_t count);
+
+#endif
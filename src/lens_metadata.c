@@ -0,0 +1,101 @@
+#include "lens_metadata.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include "aligned_malloc.h"
+#include "lens_db.h"
+
+static lens_db_t* calibration_db;
+
+// Cold side table for lenses missing from the database, filled lazily. Readers only take the lock on first touch.
+static LensDescriptor_t descriptor_table[LENS_MAX_IDS];
+static int descriptor_loaded[LENS_MAX_IDS];     // atomic
+static mtx_t descriptor_lock;
+static once_flag descriptor_once = ONCE_FLAG_INIT;
+
+static void descriptor_lock_init(void)
+{
+    mtx_init( &descriptor_lock, mtx_plain );
+}
+
+int lens_metadata_open(const char* db_path)
+{
+    calibration_db = lens_db_open( db_path );
+    if( !calibration_db )
+    {
+        printf("[LensDB] No calibration database at %s, using simulated EEPROM\n", db_path);
+        return -1;
+    }
+    printf("[LensDB] Mapped %u lens profiles from %s\n", calibration_db->header->count, db_path);
+    return 0;
+}
+
+void lens_metadata_close(void)
+{
+    lens_db_close( calibration_db );
+    calibration_db = NULL;
+}
+
+LensProfile_t* lens_profile_load(uint32_t id)
+{
+    // Zero-copy: the cache holds a pointer straight into the mapping
+    const LensProfile_t* mapped = lens_db_find( calibration_db, id );
+    if( mapped )
+    {
+        return (LensProfile_t*)mapped;
+    }
+
+    // Mock function simulating slow hardware access
+    usleep(20000); // 20ms "Hardware Latency"
+    LensProfile_t* p = aligned_malloc_tagged( sizeof(LensProfile_t), LENS_CACHE_LINE, ALLOC_TAG_CACHE );
+    if( !p )
+    {
+        return NULL;
+    }
+    memset( p, 0, sizeof(LensProfile_t) );
+    p->lens_id = id;
+    p->gain_factor = 1.2f + (id * 0.1f);
+    return p;
+}
+
+void lens_profile_free(void* profile)
+{
+    if( lens_db_owns( calibration_db, profile ) )
+    {
+        return;
+    }
+    free_aligned( profile );
+}
+
+const LensDescriptor_t* lens_descriptor_get(uint32_t id)
+{
+    const LensDescriptor_t* mapped = lens_db_find_descriptor( calibration_db, id );
+    if( mapped )
+    {
+        return mapped;
+    }
+    if( id >= LENS_MAX_IDS )
+    {
+        return NULL;
+    }
+    if( __atomic_load_n( &descriptor_loaded[id], __ATOMIC_ACQUIRE ) )
+    {
+        return &descriptor_table[id];
+    }
+
+    call_once( &descriptor_once, descriptor_lock_init );
+    mtx_lock( &descriptor_lock );
+    if( !descriptor_loaded[id] )
+    {
+        LensDescriptor_t* d = &descriptor_table[id];
+        d->lens_id = id;
+        d->calibration_date = 20240101 + id;
+        snprintf( d->lens_name, LENS_NAME_LEN, "LumaLens %u", id );
+        __atomic_store_n( &descriptor_loaded[id], 1, __ATOMIC_RELEASE );
+    }
+    mtx_unlock( &descriptor_lock );
+    return &descriptor_table[id];
+}
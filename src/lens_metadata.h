@@ -0,0 +1,53 @@
+#ifndef LENS_METADATA_H
+#define LENS_METADATA_H
+
+#include <stdint.h>
+
+#define LENS_CACHE_LINE   64
+#define LENS_NAME_LEN     64
+#define LENS_MAX_IDS      32     // Lens IDs the descriptor side table can hold
+
+// --- Hot record ---
+// Everything the ISP reads on every frame, packed into exactly one cache line.
+// This is what the metadata cache stores.
+typedef struct __attribute__((aligned(LENS_CACHE_LINE))) {
+    uint32_t lens_id;
+    float gain_factor;
+    float distortion_k[6];          // radial distortion coefficients
+    float vignette_params[4];
+    float chromatic_aberration[3];
+} LensProfile_t;                    // 60 bytes, padded to 64
+
+_Static_assert(sizeof(LensProfile_t) == LENS_CACHE_LINE, "LensProfile_t must fit one cache line");
+
+// --- Cold record ---
+// Descriptive fields the frame path never touches, kept in a side table
+// and only read for logging/UI.
+typedef struct {
+    uint32_t lens_id;
+    uint32_t calibration_date;
+    char lens_name[LENS_NAME_LEN];
+} LensDescriptor_t;
+
+// Maps the calibration database at db_path (see lens_db.h). Returns 0 on
+// success; on failure profiles fall back to the simulated EEPROM read.
+int lens_metadata_open(const char* db_path);
+
+// Unmaps the database. Profiles from it must no longer be in use.
+void lens_metadata_close(void);
+
+// Returns the hot calibration record for a lens. With a database this is a
+// pointer into the mapping (a miss costs a page fault at most); otherwise it
+// simulates a slow EEPROM read into a cache-line aligned heap copy.
+// Release with lens_profile_free().
+LensProfile_t* lens_profile_load(uint32_t id);
+
+// Frees a profile returned by lens_profile_load(), usable as a cache value
+// destructor. Records that live in the database mapping are left alone.
+void lens_profile_free(void* profile);
+
+// Returns the cold descriptor for a lens, from the database or read on first use.
+// Descriptors stay valid until lens_metadata_close(). NULL if unknown and id >= LENS_MAX_IDS.
+const LensDescriptor_t* lens_descriptor_get(uint32_t id);
+
+#endif
@@ -0,0 +1,137 @@
+#include "lens_prefetch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LENS_NONE UINT32_MAX
+
+// Loads a profile unless the cache already has it. The ISP may race us on the
+// same lens; the second put just replaces the first.
+static void prefetch_profile(lens_prefetcher_t* pf, uint32_t lens_id)
+{
+    if( lru_cache_contains( pf->cache, lens_id ) )
+    {
+        return;
+    }
+    LensProfile_t* profile = lens_profile_load( lens_id );
+    if( profile )
+    {
+        lru_cache_put( pf->cache, lens_id, profile );
+        pf->loads++;
+        printf("[PREFETCH] Loaded Lens %u ahead of the ISP\n", lens_id);
+    }
+}
+
+// Most frequent successor of 'lens_id' seen so far, LENS_NONE if unknown
+static uint32_t predict_next(const lens_prefetcher_t* pf, uint32_t lens_id)
+{
+    uint32_t best = LENS_NONE;
+    uint32_t best_count = 0;
+    for( uint32_t next = 0; next < LENS_MAX_IDS; next++ )
+    {
+        if( pf->transitions[lens_id][next] > best_count )
+        {
+            best_count = pf->transitions[lens_id][next];
+            best = next;
+        }
+    }
+    return best;
+}
+
+static int prefetch_thread_loop(void* arg)
+{
+    lens_prefetcher_t* pf = (lens_prefetcher_t*)arg;
+    while( true )
+    {
+        mtx_lock( &pf->lock );
+        while( !pf->pending && !pf->stop )
+        {
+            cnd_wait( &pf->wake, &pf->lock );
+        }
+        if( pf->stop )
+        {
+            mtx_unlock( &pf->lock );
+            break;
+        }
+        pf->pending = false;
+        mtx_unlock( &pf->lock );
+
+        uint32_t lens_id = __atomic_load_n( &pf->observed, __ATOMIC_ACQUIRE );
+        if( lens_id >= LENS_MAX_IDS )
+        {
+            continue;
+        }
+        if( pf->has_last && pf->last_lens != lens_id )
+        {
+            pf->transitions[pf->last_lens][lens_id]++;
+        }
+        pf->last_lens = lens_id;
+        pf->has_last = true;
+
+        // The sensor sees the new lens a full queue ahead of the ISP
+        prefetch_profile( pf, lens_id );
+
+        uint32_t next = predict_next( pf, lens_id );
+        if( next != LENS_NONE )
+        {
+            prefetch_profile( pf, next );
+        }
+    }
+    return 0;
+}
+
+lens_prefetcher_t* lens_prefetch_start(lru_cache_t* cache)
+{
+    lens_prefetcher_t* pf = calloc( 1, sizeof(lens_prefetcher_t) );
+    if( !pf )
+    {
+        return NULL;
+    }
+    pf->cache = cache;
+    pf->observed = LENS_NONE;
+    mtx_init( &pf->lock, mtx_plain );
+    cnd_init( &pf->wake );
+    if( thrd_create( &pf->thread, prefetch_thread_loop, pf ) != thrd_success )
+    {
+        cnd_destroy( &pf->wake );
+        mtx_destroy( &pf->lock );
+        free( pf );
+        return NULL;
+    }
+    return pf;
+}
+
+void lens_prefetch_observe(lens_prefetcher_t* pf, uint32_t lens_id)
+{
+    if( !pf )
+    {
+        return;
+    }
+    // Steady state is one atomic exchange per frame, no lock
+    if( __atomic_exchange_n( &pf->observed, lens_id, __ATOMIC_ACQ_REL ) == lens_id )
+    {
+        return;
+    }
+    mtx_lock( &pf->lock );
+    pf->pending = true;
+    cnd_signal( &pf->wake );
+    mtx_unlock( &pf->lock );
+}
+
+void lens_prefetch_stop(lens_prefetcher_t* pf)
+{
+    if( !pf )
+    {
+        return;
+    }
+    mtx_lock( &pf->lock );
+    pf->stop = true;
+    cnd_signal( &pf->wake );
+    mtx_unlock( &pf->lock );
+    thrd_join( pf->thread, NULL );
+
+    printf("[PREFETCH] %u profiles loaded ahead of the ISP\n", pf->loads);
+    cnd_destroy( &pf->wake );
+    mtx_destroy( &pf->lock );
+    free( pf );
+}
@@ -0,0 +1,41 @@
+#ifndef LENS_PREFETCH_H
+#define LENS_PREFETCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <threads.h>
+
+#include "lru_cache.h"
+#include "lens_metadata.h"
+
+// --- Predictive lens-profile prefetch ---
+// The sensor posts the lens_id of every captured frame. A background thread
+// learns a first-order Markov table of lens transitions and loads both the
+// newly observed lens and its most likely successor into the metadata cache,
+// so the profile is usually resident before the frame reaches the ISP.
+typedef struct {
+    lru_cache_t* cache;
+    uint32_t transitions[LENS_MAX_IDS][LENS_MAX_IDS];  // prefetch thread only
+    uint32_t last_lens;                                // prefetch thread only
+    bool has_last;
+
+    uint32_t observed;      // latest lens posted by the sensor (atomic)
+    bool pending;
+    bool stop;
+    mtx_t lock;
+    cnd_t wake;
+    thrd_t thread;
+
+    uint32_t loads;         // profiles loaded ahead of the ISP
+} lens_prefetcher_t;
+
+// Starts the prefetch thread for the given metadata cache, NULL on failure
+lens_prefetcher_t* lens_prefetch_start(lru_cache_t* cache);
+
+// Called by the sensor for every frame; only signals the thread when the lens changes
+void lens_prefetch_observe(lens_prefetcher_t* pf, uint32_t lens_id);
+
+// Stops and joins the prefetch thread and frees it
+void lens_prefetch_stop(lens_prefetcher_t* pf);
+
+#endif
@@ -7,8 +7,18 @@
 #include <time.h>
 
 #include "aligned_malloc.h"
+#include "slab_pool.h"
+#include "arena.h"
+#include "thread_pool.h"
+#include "isp_gain.h"
+#include "lens_remap.h"
 #include "ring_buffer.h"
 #include "lru_cache.h"
+#include "lens_metadata.h"
+#include "lens_prefetch.h"
+#include "numa_place.h"
+#include "frame_reorder.h"
+#include "dma_engine.h"
 
 // --- Constants & Configuration ---
 #define FRAME_WIDTH       1920
@@ -17,7 +27,22 @@
 #define FRAME_SIZE        FRAME_WIDTH*FRAME_HEIGHT*BYTE_PER_PIXEL
 #define BUFFER_COUNT      6      // Typical for triple-buffering + 1 spare
 #define ALIGNMENT         64     // Cache-line alignment for Apple Silicon
+#define FRAME_POOL_FLAGS  SLAB_POOL_HUGE_PAGES  // 2 MB pages cut TLB misses on full-frame passes
+#define FRAME_POOL_PREFAULT_THREADS 4   // 0 leaves faulting to the first capture
+#define FRAME_POOL_MLOCK  true          // Pin the pool so it is never paged out mid-stream
+#define SENSOR_INTERVAL_NS 500000000ULL  // Frame period; the sensor only schedules, DMA engines do the writing
+#define DMA_ENGINE_COUNT  2      // Captures that can be transferring at once
+#define ISP_WORKER_COUNT  3      // Frames processed in parallel; output order is restored by the reorder stage
+#define TILE_THREADS      4      // Shared by all ISP workers for the per-frame tile stages
+#define TILE_WIDTH        256    // 256 x 64 px x 3 B = 48 KB, a tile stays in L2 while it is worked on
+#define TILE_HEIGHT       64
+#define TILES_X           ( ( FRAME_WIDTH + TILE_WIDTH - 1 ) / TILE_WIDTH )
+#define TILES_Y           ( ( FRAME_HEIGHT + TILE_HEIGHT - 1 ) / TILE_HEIGHT )
+#define ISP_ARENA_SIZE    ( 256 * 1024 )  // Per-worker scratch, reset every frame
+#define MEMORY_BUDGET     ( 48u * 1024 * 1024 )  // Checked by LUMA_ALLOC_STATS builds
 #define METADATA_CACHE_SZ 10     // Max lens profiles in LRU
+#define QUEUE_BYTES       ( sizeof( ring_buffer_t ) + sizeof( void* ) * BUFFER_COUNT )  // ring_buffer mallocs these itself
+#define LENS_DB_PATH      "lens_calib.db"   // Override with LUMA_LENS_DB
 volatile bool running = false;
 
 typedef enum POOL_STATES
@@ -27,61 +52,63 @@ typedef enum POOL_STATES
     STATE_READY
 } P_State;
 
-typedef struct {
-    uint32_t lens_id;
-    float gain_factor;
-    char lens_name[64];
-    float distortion_k[6];
-    float vignette_params[4];
-    float chromatic_aberration[3];
-    uint32_t calibration_date;
-} LensProfile_t;
-
 // --- Buffer Metadata ---
 typedef struct {
-    uint32_t id;
+    _Alignas( ALIGNMENT ) uint32_t id;  // Own line: sensor and ISP write different frames' state
     void* virt_addr;        // Allocated via your aligned_malloc
     size_t size;
     uint64_t timestamp_ns;  // To simulate sync
     P_State state;       // enum for states
     uint32_t lens_id;
+    uint32_t sequence;      // Capture order, assigned by the sensor
+    uint8_t luma_mean;      // AE statistic, filled in by processing
+    dma_transfer_t dma;     // This frame's capture transfer, reused every capture
 } FrameBuffer_t;
 
+struct CameraDevice;
+
 typedef struct {
+    struct CameraDevice* dev;
+    uint32_t index;
+    thrd_t thread;
+    uint64_t busy_ns;           // Time spent on frames, read by other threads for utilization
+    uint32_t frames;
+} isp_worker_t;
+
+typedef struct CameraDevice {
     // 1. The Parking Lot (Storage)
-    // We allocate 4 actual blocks of memory here.
-    FrameBuffer_t* pool[BUFFER_COUNT];
+    // One array of frame structs; pixel memory is carved from one slab reservation.
+    FrameBuffer_t pool[BUFFER_COUNT];
+    slab_pool_t* frame_pool;
+    int numa_node;              // Node for frames and pipeline threads, NUMA_NODE_ANY to leave placement alone
 
     // 2. The Conveyor Belt (Flow)
     // This stores POINTERS to the buffers in the pool above.
     // It is initialized to hold 'FrameBuffer_t*' types.
+    // Free frames go back to frame_pool's lock-free LIFO instead of a queue:
+    // their order does not matter, and the last frame released is the cache-warm one.
     ring_buffer_t* ready_to_process_queue;
-    ring_buffer_t* ready_to_write_queue;
+    thread_pool_t* tile_pool;   // Splits each frame's heavy stages across cores
+    // Workers finish out of order; frames leave through here in capture order
+    frame_reorder_t reorder;
+    isp_worker_t isp_workers[ISP_WORKER_COUNT];
+    uint64_t isp_start_ns;
 
     // 3. The Knowledge Base (Optimization)
     // Maps a 'LensID' to a 'CalibrationData' struct.
     lru_cache_t* lens_metadata_cache;
+    lru_cache_t* lens_remap_cache;  // Lens correction tables, keyed by lens_remap_key()
+    lens_prefetcher_t* lens_prefetcher;
+    uint32_t capture_count;     // Sensor thread only
+    uint32_t sensor_noise_bits; // Synthetic read noise, 0 for the plain gradient
+    dma_engine_t* dma;          // Writes captured frames; the sensor thread only schedules
+    FILE* lens_trace;           // Optional lens_id access trace for tools/cache_sim
     uint32_t processed_count;
     mtx_t lock;
     uint32_t sensor_dropped_frames;
     uint32_t isp_dropped_frames;
 } CameraDevice_t;
 
-bool is_buffer_safe_to_overwrite(void* ptr) {
-    FrameBuffer_t* buf = (FrameBuffer_t*)ptr;
-    // Only recycle if it's waiting in the queue, NOT currently in the ISP
-    return __atomic_load_n(&buf->state, __ATOMIC_ACQUIRE) == STATE_READY;
-}
-
-// Mock function simulating slow hardware access
-LensProfile_t* load_lens_params_from_eeprom(uint32_t id) {
-    usleep(20000); // 20ms "Hardware Latency"
-    LensProfile_t* p = malloc(sizeof(LensProfile_t));
-    p->lens_id = id;
-    p->gain_factor = 1.2f + (id * 0.1f);
-    return p;
-}
-
 // High-resolution timer for metadata
 uint64_t get_timestamp_ns() {
     struct timespec ts;
@@ -89,36 +116,141 @@ uint64_t get_timestamp_ns() {
     return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
 }
 
+// Pops the most recently released frame, NULL when every frame is in flight
+static inline FrameBuffer_t* frame_acquire(CameraDevice_t* dev) {
+    void* pixels = slab_alloc( dev->frame_pool );
+    return pixels ? &dev->pool[slab_index_of( dev->frame_pool, pixels )] : NULL;
+}
+
+static inline void frame_release(CameraDevice_t* dev, FrameBuffer_t* buf) {
+    slab_free( dev->frame_pool, buf->virt_addr );
+}
+
+// Share of wall time each ISP worker has spent on frames since start
+void print_isp_utilization(CameraDevice_t* dev)
+{
+    uint64_t wall_ns = get_timestamp_ns() - dev->isp_start_ns;
+    for( int i = 0; i < ISP_WORKER_COUNT; i++ )
+    {
+        isp_worker_t* worker = &dev->isp_workers[i];
+        uint64_t busy_ns = __atomic_load_n( &worker->busy_ns, __ATOMIC_RELAXED );
+        printf("[ISP] Worker %d: %u frames, %.1f%% busy\n", i,
+                __atomic_load_n( &worker->frames, __ATOMIC_RELAXED ),
+                wall_ns ? 100.0 * busy_ns / wall_ns : 0.0);
+    }
+}
 
-void simulate_sensor_capture(FrameBuffer_t* buf) {
+// Reorder stage output: frames arrive here in capture order, whichever worker finished them
+void deliver_frame(void* item, void* ctx)
+{
+    CameraDevice_t* dev = (CameraDevice_t*)ctx;
+    FrameBuffer_t* buffer = (FrameBuffer_t*)item;
+    printf("[ISP] Processed buffer ID: %u | Seq: %u | Lens: %u | Luma: %u | Timestamp: %lu\n",
+                buffer->id, buffer->sequence, buffer->lens_id, buffer->luma_mean, buffer->timestamp_ns);
+    // Written here rather than by the workers so the trace keeps capture order
+    if( dev->lens_trace )
+    {
+        fprintf( dev->lens_trace, "%u\n", buffer->lens_id );
+    }
+    mtx_lock(&dev->lock);
+    dev->processed_count++;
+    if (dev->processed_count % 30 == 0) {
+        printf("[ISP] Processed frame ID: %u | Lens: %u | Timestamp: %lu\n", 
+                buffer->id, buffer->lens_id, buffer->timestamp_ns);
+        print_isp_utilization( dev );
+    }
+    mtx_unlock(&dev->lock);
+    // Last touch: once released the sensor may be writing into it
+    frame_release( dev, buffer );
+}
+
+bool is_buffer_safe_to_overwrite(void* ptr) {
+    FrameBuffer_t* buf = (FrameBuffer_t*)ptr;
+    // Only recycle if it's waiting in the queue, NOT currently in the ISP
+    return __atomic_load_n(&buf->state, __ATOMIC_ACQUIRE) == STATE_READY;
+}
+
+
+// Starts the capture of one frame: stamps its metadata and hands the
+// readout to a DMA engine. The frame is published when the transfer completes.
+bool simulate_sensor_capture(CameraDevice_t* dev, FrameBuffer_t* buf) {
     if (!buf || !buf->virt_addr) 
     {
         printf("[ERROR] Invalid buffer passed to simulate_sensor_capture\n");
-        return;
+        return false;
     }
-    // In a real Apple driver, this would be a DMA transfer.
-    // We'll fill the buffer with a "gradient" that changes over time
-    // so we can visually or programmatically verify frames are unique.
-    uint8_t* data = (uint8_t*)buf->virt_addr;
-    uint8_t frame_seed = (uint8_t)(buf->id % 255);
-
     if( buf->size != FRAME_SIZE )
     {
         printf("[ERROR] Invalid buffer size passed to simulate_sensor_capture\n");
-        return;
+        return false;
     }
-    // We use a simple loop to simulate "writing" to memory
-    // In a real-world scenario, you'd use a faster method or hardware.
-    for (size_t i = 0; i < buf->size; i++) {
-        data[i] = (uint8_t)((i + frame_seed) % 256);
+    if( !dev->dma )
+    {
+        return false;
     }
 
     // Attach metadata: Simulate a shifting Lens ID (e.g., zooming)
-    buf->lens_id = (buf->id / 10) % 5; // Changes Lens ID every 10 frames
-    buf->timestamp_ns = get_timestamp_ns(); 
+    buf->lens_id = (buf->sequence / 10) % 5; // Changes Lens ID every 10 frames
+    buf->timestamp_ns = get_timestamp_ns(); // Start of exposure, so capture order is timestamp order
+
+    // In a real Apple driver, this would be a DMA transfer.
+    // We'll fill the buffer with a "gradient" that changes over time
+    // so we can visually or programmatically verify frames are unique,
+    // or copy recorded frames when a replay file is mapped.
+    dma_transfer_t* transfer = &buf->dma;
+    transfer->dst = buf->virt_addr;
+    transfer->size = buf->size;
+    transfer->source = dev->dma->replay ? DMA_SOURCE_REPLAY : DMA_SOURCE_PATTERN;
+    transfer->seed = (uint8_t)(buf->id % 255);
+    transfer->noise_seed = buf->sequence;
+    transfer->noise_bits = dev->sensor_noise_bits;
+    transfer->replay_offset = (uint64_t)buf->sequence * FRAME_SIZE;
+    transfer->cookie = buf;
+    return dma_submit( dev->dma, transfer );
+}
+
+// One frame's tile stage, shared by the pool workers running its tiles
+typedef struct {
+    uint8_t* data;
+    const uint8_t* source;  // Captured frame to correct from, NULL for gain only in place
+    const lens_remap_t* remap;  // Lens correction, gain included
+    uint16_t gain_q8;       // Lens gain, Q8.8, when there is no correction
+    uint32_t* histograms;   // 256 bins per tile, so tiles never write the same line
+} tile_job_t;
+
+// Lens correction (or gain alone), then the luma histogram of the result, while the tile is still in cache
+void tile_correct_statistics( void* arg, uint32_t tile )
+{
+    tile_job_t* job = (tile_job_t*)arg;
+    uint32_t* histogram = job->histograms + tile * 256;
+    uint32_t x0 = ( tile % TILES_X ) * TILE_WIDTH;
+    uint32_t y0 = ( tile / TILES_X ) * TILE_HEIGHT;
+    uint32_t x1 = x0 + TILE_WIDTH < FRAME_WIDTH ? x0 + TILE_WIDTH : FRAME_WIDTH;
+    uint32_t y1 = y0 + TILE_HEIGHT < FRAME_HEIGHT ? y0 + TILE_HEIGHT : FRAME_HEIGHT;
+    memset( histogram, 0, 256 * sizeof( uint32_t ) );
+    if( job->source )
+    {
+        lens_remap_apply( job->remap, job->source, job->data, x0, y0, x1, y1 );
+    }
+    for( uint32_t y = y0; y < y1; y++ )
+    {
+        uint8_t* rgb = job->data + ( (size_t)y * FRAME_WIDTH + x0 ) * BYTE_PER_PIXEL;
+        if( !job->source )
+        {
+            gain_apply_fixed( rgb, ( x1 - x0 ) * BYTE_PER_PIXEL, job->gain_q8 );
+        }
+        for( uint32_t x = x0; x < x1; x++, rgb += BYTE_PER_PIXEL )
+        {
+            histogram[( rgb[0] * 77 + rgb[1] * 150 + rgb[2] * 29 ) >> 8]++;
+        }
+    }
 }
 
-void processing( FrameBuffer_t* buf, LensProfile_t* profile )
+// Processes into buf. With a remap table, captured holds the capture and buf is
+// a free frame that receives the corrected image; captured is released as soon
+// as nothing reads it. Without one, captured is NULL and buf gets gain in place.
+void processing( CameraDevice_t* dev, FrameBuffer_t* buf, FrameBuffer_t* captured,
+                 LensProfile_t* profile, const lens_remap_t* remap, arena_t* scratch )
 {
     if( !buf || !buf->virt_addr )
     {
@@ -126,11 +258,54 @@ void processing( FrameBuffer_t* buf, LensProfile_t* profile )
         return;
     }
     uint8_t* data = (uint8_t*)buf->virt_addr;
-    float gain = profile->gain_factor;
 
-    // Just touch the first few pixels to simulate work without killing the CPU
-    for (size_t i = 0; i < 100; i++) {
-        data[i] = (uint8_t)(data[i] * gain > 255 ? 255 : data[i] * gain);
+    // Correction and statistics stages, fused per tile on the tile pool: lens
+    // distortion, vignetting and gain in one pass driven by the lens's remap
+    // table, then a luma histogram for auto exposure, one partial histogram
+    // per tile, merged once all tiles join. Without a table the tiles only
+    // get the gain/clamp kernel.
+    // Scratch comes from the worker's arena, released when the frame completes.
+    tile_job_t job;
+    job.data = data;
+    job.source = NULL;
+    job.remap = remap;
+    job.gain_q8 = gain_to_fixed( profile->gain_factor );
+    job.histograms = arena_alloc( scratch, TILES_X * TILES_Y * 256 * sizeof( uint32_t ), ALIGNMENT );
+    if( remap && captured )
+    {
+        // Tiles sample around themselves, so they read the untouched capture
+        // and write the free frame rather than correcting in place
+        job.source = (const uint8_t*)captured->virt_addr;
+    }
+    if( job.histograms )
+    {
+        thread_pool_parallel_for( dev->tile_pool, TILES_X * TILES_Y, tile_correct_statistics, &job );
+        uint64_t sum = 0;
+        for( uint32_t tile = 0; tile < TILES_X * TILES_Y; tile++ )
+        {
+            const uint32_t* histogram = job.histograms + tile * 256;
+            for( uint32_t level = 0; level < 256; level++ )
+            {
+                sum += (uint64_t)level * histogram[level];
+            }
+        }
+        buf->luma_mean = (uint8_t)( sum / ( FRAME_WIDTH * FRAME_HEIGHT ) );
+    }
+    else if( job.source )
+    {
+        // No room for statistics; the frame is still corrected, on this thread
+        lens_remap_apply( remap, job.source, data, 0, 0, FRAME_WIDTH, FRAME_HEIGHT );
+    }
+    else
+    {
+        // No room for statistics; the frame still gets its gain
+        gain_apply_fixed( data, buf->size, job.gain_q8 );
+    }
+    if( captured )
+    {
+        // The corrected image is in buf, so the sensor can have the capture back
+        __atomic_store_n( &captured->state, STATE_READY, __ATOMIC_RELEASE );
+        frame_release( dev, captured );
     }
 
     // Simulate "ISP Latency" - heavier processing takes longer
@@ -146,46 +321,98 @@ void processing( FrameBuffer_t* buf, LensProfile_t* profile )
  * 3. Initialize your LRU Cache to store simulated "Lens Correction Matrices".
  */
 
-void camera_init(CameraDevice_t* dev)
+bool camera_init(CameraDevice_t* dev)
 {
+    alloc_stats_set_budget( MEMORY_BUDGET );
     dev->ready_to_process_queue = create_ring_buffer( sizeof( void* ), BUFFER_COUNT );
-    dev->ready_to_write_queue = create_ring_buffer( sizeof( void* ), BUFFER_COUNT );
 
-    if( !dev->ready_to_process_queue || !dev->ready_to_write_queue )
+    if( !dev->ready_to_process_queue )
     {
         printf("Queue creation failed \n");
-        return;
+        return false;
     }
+    alloc_stats_record( ALLOC_TAG_QUEUE, QUEUE_BYTES, 0 );
 
     size_t frame_bytes = FRAME_SIZE;
 
-    for(int i = 0; i < BUFFER_COUNT; i++) {
-        // 1. Allocate the struct itself
-        dev->pool[i] = malloc(sizeof(FrameBuffer_t));
-        if( !dev->pool[i] )
-        {
-            return;
-        }
-        // 2. Allocate the actual large pixel memory (Zero-Copy area)
-        dev->pool[i]->virt_addr = aligned_malloc(frame_bytes, ALIGNMENT);
-        if( !is_aligned( dev->pool[i]->virt_addr , ALIGNMENT ))
-        {
-            printf( "Aligned malloc failed\n");
-            return;
-        }
-        dev->pool[i]->size = frame_bytes;
-        dev->pool[i]->id = i;
-        dev->pool[i]->state = STATE_READY;
+    // Lens correction reads a captured frame a few bytes past its end
+    dev->frame_pool = slab_pool_create( frame_bytes + LENS_REMAP_SRC_PAD, BUFFER_COUNT, ALIGNMENT, FRAME_POOL_FLAGS );
+    if( !dev->frame_pool )
+    {
+        printf( "Frame pool allocation failed\n");
+        return false;
+    }
+    // Pool pages are untouched until the prefault below (or the sensor's first
+    // capture without it), so the policy decides where they land
+    if( numa_bind_memory( dev->frame_pool->base, dev->frame_pool->slot_size * BUFFER_COUNT, dev->numa_node ) )
+    {
+        printf("[System] Frame pool and pipeline threads placed on NUMA node %d of %d\n", dev->numa_node, numa_node_count());
+    }
+    // Take every page fault now rather than on the first pass over each frame
+    if( FRAME_POOL_PREFAULT_THREADS > 0 )
+    {
+        uint64_t start_ns = get_timestamp_ns();
+        slab_pool_prefault( dev->frame_pool, FRAME_POOL_PREFAULT_THREADS, FRAME_POOL_MLOCK );
+        printf("[System] Frame pool ready in %.2f ms (%d threads, %s)\n",
+                ( get_timestamp_ns() - start_ns ) / 1e6, FRAME_POOL_PREFAULT_THREADS,
+                dev->frame_pool->locked ? "locked in RAM" : "not locked");
+    }
+    // Reported after the prefault, which confirms whether THP took
+    printf("[System] Frame pool: %d x %zu bytes, backed by %s\n", BUFFER_COUNT, dev->frame_pool->slot_size,
+            ( dev->frame_pool->flags & SLAB_POOL_HUGE_PAGES ) ? page_mode_name( dev->frame_pool->page_mode ) : "malloc");
 
-        // 3. Push the POINTER to the struct into the queue
-        FrameBuffer_t* ptr = dev->pool[i];
-        write_to_buffer(dev->ready_to_write_queue, ptr );
+    for(int i = 0; i < BUFFER_COUNT; i++) {
+        // Frame i owns slot i of pixel memory (Zero-Copy area) for its lifetime.
+        // Every slot starts on the pool's free list, so every frame starts free.
+        FrameBuffer_t* ptr = &dev->pool[i];
+        ptr->virt_addr = slab_slot( dev->frame_pool, i );
+        ptr->size = frame_bytes;
+        ptr->id = i;
+        ptr->state = STATE_READY;
     }
-    dev->lens_metadata_cache = lru_cache_create( BUFFER_COUNT );
+    const char* lens_db_path = getenv( "LUMA_LENS_DB" );
+    lens_metadata_open( lens_db_path ? lens_db_path : LENS_DB_PATH );
+    dev->lens_metadata_cache = lru_cache_create( METADATA_CACHE_SZ );
+    lru_cache_set_value_free( dev->lens_metadata_cache, lens_profile_free );
+    dev->lens_prefetcher = lens_prefetch_start( dev->lens_metadata_cache );
+    dev->lens_remap_cache = lru_cache_create( METADATA_CACHE_SZ );
+    lru_cache_set_value_free( dev->lens_remap_cache, free_aligned );
+    dev->capture_count = 0;
+    const char* noise_bits = getenv( "LUMA_SENSOR_NOISE" );
+    dev->sensor_noise_bits = noise_bits ? (uint32_t)atoi( noise_bits ) : 0;
+    dev->dma = dma_engine_create( DMA_ENGINE_COUNT, dev->numa_node, getenv( "LUMA_SENSOR_REPLAY" ) );
+    if( !dev->dma )
+    {
+        // The sensor thread reaps and submits through it every frame period
+        printf("DMA engine start failed\n");
+        return false;
+    }
+    if( dev->dma->replay )
+    {
+        printf("[System] Sensor replaying %.1f frames from file, wrapping at the end\n",
+                (double)dev->dma->replay_size / ( FRAME_SIZE ));
+    }
+    const char* trace_path = getenv( "LUMA_LENS_TRACE" );
+    dev->lens_trace = trace_path ? fopen( trace_path, "w" ) : NULL;
     dev->isp_dropped_frames = 0;
     dev->sensor_dropped_frames = 0;
     dev->processed_count = 0;
     mtx_init( &dev->lock, mtx_plain );
+    if( frame_reorder_init( &dev->reorder, deliver_frame, dev ) != 0 )
+    {
+        printf("Frame reorder init failed\n");
+        return false;
+    }
+    dev->tile_pool = thread_pool_create( TILE_THREADS );
+    printf("[System] ISP kernels using %s\n", isp_isa_name( isp_isa_active() ));
+    for( int i = 0; i < ISP_WORKER_COUNT; i++ )
+    {
+        dev->isp_workers[i].dev = dev;
+        dev->isp_workers[i].index = i;
+        dev->isp_workers[i].busy_ns = 0;
+        dev->isp_workers[i].frames = 0;
+    }
+    return true;
 }
 
 void camera_deinit(CameraDevice_t* dev)
@@ -194,32 +421,83 @@ void camera_deinit(CameraDevice_t* dev)
     {
         return;
     }
+    printf("[ISP] Reorder stage: %u delivered, %u skipped, %u late, deepest window %u of %d\n",
+            dev->reorder.delivered, dev->reorder.skipped, dev->reorder.late,
+            dev->reorder.max_pending, REORDER_WINDOW);
+    print_isp_utilization( dev );
+    frame_reorder_destroy( &dev->reorder );
+    thread_pool_print_stats( dev->tile_pool );
+    thread_pool_destroy( dev->tile_pool );
     mtx_destroy( &dev->lock );
     
-    for( int i = 0; i<BUFFER_COUNT; i++ )
-    {
-        free_aligned( dev->pool[i]->virt_addr );
-        free( dev->pool[i] );
-    }
+    // Finishes queued transfers, so no engine is writing into the pool below
+    dma_engine_destroy( dev->dma );
+
+    // Frames hold no memory of their own, the pool owns every slot
+    slab_pool_destroy( dev->frame_pool );
 
     if( dev->ready_to_process_queue )
     {
         destroy_ring_buffer( dev->ready_to_process_queue );
+        alloc_stats_release( ALLOC_TAG_QUEUE, QUEUE_BYTES, 0 );
     }
     
-    if( dev->ready_to_write_queue )
-    {
-        destroy_ring_buffer( dev->ready_to_write_queue );
-    }
+
+    // Stop the prefetcher before the cache it fills goes away
+    lens_prefetch_stop( dev->lens_prefetcher );
 
     if( dev->lens_metadata_cache )
     {
         lru_cache_free( dev->lens_metadata_cache );
     }
+    if( dev->lens_remap_cache )
+    {
+        lru_cache_free( dev->lens_remap_cache );
+    }
+    // Cached profiles may point into the mapping, so unmap after the cache
+    lens_metadata_close();
+
+    if( dev->lens_trace )
+    {
+        fclose( dev->lens_trace );
+    }
+
+    // Everything is freed by now, so non-zero live bytes are leaks
+    alloc_stats_print();
+#ifdef ALIGNED_MALLOC_STATS
+    // lru_cache mallocs its own nodes; only the cached values are counted
+    printf("[Alloc] not tracked: LRU cache nodes, %zu B per entry, up to %d entries per cache\n",
+            sizeof( Node ) + sizeof( HashNode ), METADATA_CACHE_SZ );
+#endif
 }
 
 // --- Module 2: The Producer (Hardware/Sensor) ---
 
+// A capture transfer finished: hand the frame to the ISP queue
+void publish_frame( CameraDevice_t* dev, dma_transfer_t* transfer )
+{
+    FrameBuffer_t* buffer = (FrameBuffer_t*)transfer->cookie;
+    if( transfer->status != DMA_STATUS_DONE )
+    {
+        printf("[SENSOR] DMA error on Buffer ID: %u, frame dropped\n", buffer->id);
+        frame_reorder_skip( &dev->reorder, buffer->sequence );
+        frame_release( dev, buffer );
+        return;
+    }
+    __atomic_store_n(&buffer->state, STATE_READY, __ATOMIC_RELEASE);
+    printf("[SENSOR] Ready for processing Buffer ID: %u (DMA engine %u, %.2f ms)\n", buffer->id,
+            transfer->engine, ( transfer->done_ns - transfer->submit_ns ) / 1e6);
+
+    FrameBuffer_t* recycled_buffer = write_to_buffer( dev->ready_to_process_queue, buffer );
+
+    if( recycled_buffer )
+    {
+        printf("[SENSOR] Getting back unprocessed buffer ID: %u\n", recycled_buffer->id);
+        frame_reorder_skip( &dev->reorder, recycled_buffer->sequence );
+        frame_release( dev, recycled_buffer );
+    }
+}
+
 /**
  * TODO: Implement 'sensor_thread_loop'
  * Goal: Simulate the 60fps hardware interrupt.
@@ -232,17 +510,30 @@ void camera_deinit(CameraDevice_t* dev)
 int sensor_thread_loop( void* arg )
 {
     CameraDevice_t* dev = (CameraDevice_t*)arg;
+    numa_bind_thread( dev->numa_node );
+    uint64_t next_capture_ns = get_timestamp_ns() + SENSOR_INTERVAL_NS;
     while( running )
     {
-        usleep( 500000 );
+        // Publish transfers as they land, until the next capture is due
+        dma_transfer_t* done;
+        while( ( done = dma_reap( dev->dma, next_capture_ns ) ) )
+        {
+            alloc_hot_path_enter();
+            publish_frame( dev, done );
+            alloc_hot_path_exit();
+        }
+        next_capture_ns += SENSOR_INTERVAL_NS;
+
         FrameBuffer_t* buffer;
-        read_from_buffer( dev->ready_to_write_queue, &buffer );
+        buffer = frame_acquire( dev );
         
         if( !buffer )
         {
             buffer = get_stale_recycled( dev->ready_to_process_queue, is_buffer_safe_to_overwrite);
             if( buffer )
             {
+                // Its capture will never reach the reorder stage
+                frame_reorder_skip( &dev->reorder, buffer->sequence );
                 mtx_lock( &dev->lock );
                 dev->isp_dropped_frames++;
                 printf("[ISP] DROP! Recyled unprocessed buffer ID %d. Total ISP Drops: %u\n", buffer->id, dev->isp_dropped_frames);
@@ -253,20 +544,26 @@ int sensor_thread_loop( void* arg )
         if( buffer )
         {
             // printf("[SENSOR] Writing to Buffer ID: %u\n", buffer->id);
+            alloc_hot_path_enter();
             __atomic_store_n(&buffer->state, STATE_BUSY_WRITING, __ATOMIC_RELEASE);
 
-            simulate_sensor_capture( buffer );
-
-            __atomic_store_n(&buffer->state, STATE_READY, __ATOMIC_RELEASE);
-            printf("[SENSOR] Ready for processing Buffer ID: %u\n", buffer->id);
-
-            FrameBuffer_t* recycled_buffer = write_to_buffer( dev->ready_to_process_queue, buffer );
-
-            if( recycled_buffer )
+            buffer->sequence = dev->capture_count++;
+            if( simulate_sensor_capture( dev, buffer ) )
             {
-                printf("[SENSOR] Getting back unprocessed buffer ID: %u\n", recycled_buffer->id);
-                write_to_buffer( dev->ready_to_write_queue, recycled_buffer );
+                // Let the prefetcher see lens changes a queue-depth before the ISP does
+                lens_prefetch_observe( dev->lens_prefetcher, buffer->lens_id );
             }
+            else
+            {
+                // No transfer slot: the capture is lost, the frame goes straight back
+                frame_reorder_skip( &dev->reorder, buffer->sequence );
+                frame_release( dev, buffer );
+                mtx_lock( &dev->lock );
+                dev->sensor_dropped_frames++;
+                printf("[SENSOR] DROP! DMA queue full. Total Drops: %u\n", dev->sensor_dropped_frames);
+                mtx_unlock( &dev->lock );
+            }
+            alloc_hot_path_exit();
         }
         else
         {
@@ -276,6 +573,7 @@ int sensor_thread_loop( void* arg )
             mtx_unlock( &dev->lock );
         }
     }
+    return 0;
 }
 
 // --- Module 3: The Consumer (ISP/Image Processing) ---
@@ -290,47 +588,151 @@ int sensor_thread_loop( void* arg )
  * 3. PROCESS: Perform a dummy operation (e.g., calculate average brightness).
  * 4. RELEASE: Return the buffer to the "Empty" pool.
  */
+
+// Lens correction table for a profile at the sensor resolution, built on first
+// use and kept in its own metadata cache. Looked up directly, not through the
+// front cache: front slots are indexed by key alone, so this lookup could
+// release the profile's slot while the frame still uses the profile.
+// Returns a reference to release after the frame, NULL if no table could be built.
+static Node* lens_remap_get(CameraDevice_t* dev, const LensProfile_t* profile)
+{
+    uint32_t key = lens_remap_key( profile->lens_id, FRAME_WIDTH, FRAME_HEIGHT );
+    Node* ref = lru_cache_get_ref( dev->lens_remap_cache, key );
+    if( ref )
+    {
+        const lens_remap_t* table = (const lens_remap_t*)ref->value;
+        if( table->lens_id == profile->lens_id && table->width == FRAME_WIDTH && table->height == FRAME_HEIGHT )
+        {
+            return ref;
+        }
+        // Key collision: rebuild, replacing the other lens's table
+        lru_cache_release( dev->lens_remap_cache, ref );
+    }
+
+    size_t size = lens_remap_size( FRAME_WIDTH, FRAME_HEIGHT );
+    lens_remap_t* table = size ? aligned_malloc_tagged( size, ALIGNMENT, ALLOC_TAG_CACHE ) : NULL;
+    if( !table )
+    {
+        return NULL;
+    }
+    lens_model_t model;
+    memcpy( model.distortion_k, profile->distortion_k, sizeof( model.distortion_k ) );
+    memcpy( model.vignette, profile->vignette_params, sizeof( model.vignette ) );
+    model.gain = profile->gain_factor;
+    uint64_t start_ns = get_timestamp_ns();
+    lens_remap_build( table, profile->lens_id, &model, FRAME_WIDTH, FRAME_HEIGHT );
+    printf("[ISP] Built lens %u correction table, %zu KB in %.2f ms\n", profile->lens_id, size / 1024,
+            ( get_timestamp_ns() - start_ns ) / 1e6);
+    return lru_cache_put_ref( dev->lens_remap_cache, key, table );
+}
+
 int isp_thread_loop(void* arg)
 {
-    CameraDevice_t* dev = (CameraDevice_t*)arg;
+    isp_worker_t* worker = (isp_worker_t*)arg;
+    CameraDevice_t* dev = worker->dev;
+    numa_bind_thread( dev->numa_node );
+    // Created after binding so the scratch pages are first touched on this worker's node
+    arena_t* scratch = arena_create( ISP_ARENA_SIZE, ALIGNMENT );
+    if( !scratch )
+    {
+        printf("[ISP] Scratch arena allocation failed\n");
+        return 0;
+    }
     while( running )
     {
         FrameBuffer_t* buffer;
         read_from_buffer( dev->ready_to_process_queue, &buffer );
 
-        if( buffer )
+        if( !buffer )
         {
-            printf("[ISP] Processing Buffer ID: %u\n", buffer->id);
-    
-            __atomic_store_n(&buffer->state, STATE_BUSY_PROCESSING, __ATOMIC_RELEASE);
+            // Let the sensor and the other workers run while the queue is empty
+            thrd_yield();
+            continue;
+        }
+        uint64_t start_ns = get_timestamp_ns();
+        printf("[ISP] Worker %u processing Buffer ID: %u\n", worker->index, buffer->id);
+        alloc_hot_path_enter();
+
+        __atomic_store_n(&buffer->state, STATE_BUSY_PROCESSING, __ATOMIC_RELEASE);
+
+        // Frames in a burst share a lens, so this is normally served from the
+        // thread's front cache without touching shared cache state. The
+        // front entry holds a reference, so an eviction mid-frame is safe.
+        LensProfile_t* profile = lru_front_get( dev->lens_metadata_cache, buffer->lens_id );
+        Node* profile_ref = NULL;
+        LensProfile_t fallback_profile;
+        if ( profile == NULL ) 
+        {
+            // CACHE MISS: Simulate a slow I2C/EEPROM read from the lens hardware
+            const LensDescriptor_t* lens = lens_descriptor_get( buffer->lens_id );
+            printf("[ISP] Cache Miss! Loading Lens %d (%s) calibration...\n", buffer->lens_id,
+                    lens ? lens->lens_name : "unknown");
+            LensProfile_t* loaded = lens_profile_load(buffer->lens_id); 
+            if( loaded )
+            {
+                profile_ref = lru_cache_put_ref( dev->lens_metadata_cache, buffer->lens_id, loaded );
+                profile = (LensProfile_t*)profile_ref->value;
+            }
+            else
+            {
+                // Not cached, so the next frame of this lens retries the load
+                printf("[ISP] Lens %u calibration load failed, unity gain without correction\n", buffer->lens_id);
+                memset( &fallback_profile, 0, sizeof( fallback_profile ) );
+                fallback_profile.lens_id = buffer->lens_id;
+                fallback_profile.gain_factor = 1.0f;
+                profile = &fallback_profile;
+            }
+        }
 
-            mtx_lock( &dev->lock );
-            LensProfile_t* p = lru_cache_get(dev->lens_metadata_cache, buffer->lens_id);
-            if ( p == NULL ) 
+        // A table built from the fallback would be cached as this lens's correction
+        Node* remap_ref = profile != &fallback_profile ? lens_remap_get( dev, profile ) : NULL;
+
+        // The remap cannot run in place, so the capture is corrected into a
+        // free frame that takes over its metadata and its place in the
+        // reorder stage. With no frame free it only gets its gain.
+        FrameBuffer_t* captured = NULL;
+        if( remap_ref )
+        {
+            FrameBuffer_t* output = frame_acquire( dev );
+            if( output )
             {
-                // CACHE MISS: Simulate a slow I2C/EEPROM read from the lens hardware
-                printf("[ISP] Cache Miss! Loading Lens %d calibration...\n", buffer->lens_id);
-                p = load_lens_params_from_eeprom(buffer->lens_id); 
-                lru_cache_put(dev->lens_metadata_cache, buffer->lens_id, p);
+                __atomic_store_n( &output->state, STATE_BUSY_PROCESSING, __ATOMIC_RELEASE );
+                output->timestamp_ns = buffer->timestamp_ns;
+                output->lens_id = buffer->lens_id;
+                output->sequence = buffer->sequence;
+                captured = buffer;
+                buffer = output;
             }
-            mtx_unlock(&dev->lock);
-
-            processing( buffer, p );
-            
-            __atomic_store_n(&buffer->state, STATE_READY, __ATOMIC_RELEASE);
-            printf("[ISP] Processed buffer ID: %u | Lens: %u | Timestamp: %lu\n", 
-                        buffer->id, buffer->lens_id, buffer->timestamp_ns);
-            write_to_buffer( dev->ready_to_write_queue, buffer );
-            mtx_lock(&dev->lock);
-            dev->processed_count++;
-            if (dev->processed_count % 30 == 0) {
-                printf("[ISP] Processed frame ID: %u | Lens: %u | Timestamp: %lu\n", 
-                        buffer->id, buffer->lens_id, buffer->timestamp_ns);
+            else
+            {
+                printf("[ISP] No free frame to correct Buffer ID %u into, gain only\n", buffer->id);
             }
-            mtx_unlock(&dev->lock);
-            // printf("[ISP] Buffer ID: %u Ready for Reuse\n", buffer->id);
         }
+        processing( dev, buffer, captured, profile, captured ? remap_ref->value : NULL, scratch );
+        arena_reset( scratch );
+        if( remap_ref )
+        {
+            lru_cache_release( dev->lens_remap_cache, remap_ref );
+        }
+        if( profile_ref )
+        {
+            lru_cache_release( dev->lens_metadata_cache, profile_ref );
+        }
+        
+        __atomic_store_n(&buffer->state, STATE_READY, __ATOMIC_RELEASE);
+        // Held here until every earlier capture is delivered or skipped
+        frame_reorder_complete( &dev->reorder, buffer->sequence, buffer );
+        alloc_hot_path_exit();
+        __atomic_add_fetch( &worker->busy_ns, get_timestamp_ns() - start_ns, __ATOMIC_RELAXED );
+        __atomic_add_fetch( &worker->frames, 1, __ATOMIC_RELAXED );
+        // printf("[ISP] Buffer ID: %u Ready for Reuse\n", buffer->id);
     }
+    // Front cache entries hold references into the shared cache
+    lru_front_flush( dev->lens_metadata_cache );
+    printf("[ISP] Worker %u scratch arena peak %zu of %zu bytes, %u failed allocations\n",
+            worker->index, scratch->high_water, scratch->capacity, scratch->failed);
+    arena_destroy( scratch );
+    return 0;
 }
 
 // --- Main: The Orchestrator ---
@@ -340,15 +742,24 @@ int main(void) {
     // pthread_t sensor_tid, isp_tid;
 
     printf("[System] Initializing LumaStream Camera Driver...\n");
-    camera_init(&iphone_camera);
+    const char* numa_node = getenv( "LUMA_NUMA_NODE" );
+    iphone_camera.numa_node = numa_node ? atoi( numa_node ) : NUMA_NODE_ANY;
+    if( !camera_init(&iphone_camera) )
+    {
+        return 1;
+    }
 
     running = true;
 
     thrd_t sensorThread;
-    thrd_t processingThread;
 
+    iphone_camera.isp_start_ns = get_timestamp_ns();
     thrd_create( &sensorThread, sensor_thread_loop, &iphone_camera );
-    thrd_create( &processingThread, isp_thread_loop, &iphone_camera );
+    for( int i = 0; i < ISP_WORKER_COUNT; i++ )
+    {
+        isp_worker_t* worker = &iphone_camera.isp_workers[i];
+        thrd_create( &worker->thread, isp_thread_loop, worker );
+    }
 
     // TODO: Launch Threads
     // pthread_create(&sensor_tid, NULL, sensor_thread_loop, &iphone_camera);
@@ -360,7 +771,10 @@ int main(void) {
 
     running = false;
     thrd_join(sensorThread, NULL);
-    thrd_join(processingThread, NULL);
+    for( int i = 0; i < ISP_WORKER_COUNT; i++ )
+    {
+        thrd_join( iphone_camera.isp_workers[i].thread, NULL );
+    }
 
     camera_deinit( &iphone_camera );
     
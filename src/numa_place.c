@@ -0,0 +1,110 @@
+#define _GNU_SOURCE
+#include "numa_place.h"
+
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define NUMA_MAX_NODES      64      // One unsigned long of node mask
+#define MPOL_PREFERRED_MODE 1       // From linux/mempolicy.h; falls back to other nodes when full
+
+// Parses a /sys list like "0-3,8,10-11"; calls fn for each entry, returns the count
+static int parse_sys_list(const char* path, void (*fn)(int value, void* ctx), void* ctx)
+{
+    FILE* f = fopen( path, "r" );
+    if( !f )
+    {
+        return 0;
+    }
+    int count = 0;
+    int first;
+    while( fscanf( f, "%d", &first ) == 1 )
+    {
+        int last = first;
+        int sep = fgetc( f );
+        if( sep == '-' )
+        {
+            if( fscanf( f, "%d", &last ) != 1 )
+            {
+                break;
+            }
+            sep = fgetc( f );
+        }
+        for( int v = first; v <= last; v++ )
+        {
+            if( fn )
+            {
+                fn( v, ctx );
+            }
+            count++;
+        }
+        if( sep != ',' )
+        {
+            break;
+        }
+    }
+    fclose( f );
+    return count;
+}
+
+int numa_node_count(void)
+{
+    static int nodes = 0;
+    if( nodes == 0 )
+    {
+        int n = parse_sys_list( "/sys/devices/system/node/online", NULL, NULL );
+        nodes = n > 0 ? n : 1;
+    }
+    return nodes;
+}
+
+bool numa_placement_active(int node)
+{
+    return node != NUMA_NODE_ANY && node >= 0 && node < NUMA_MAX_NODES && numa_node_count() > 1;
+}
+
+bool numa_bind_memory(void* ptr, size_t size, int node)
+{
+    if( !numa_placement_active( node ) || !ptr || size == 0 )
+    {
+        return false;
+    }
+    // mbind works on whole pages; shrink to the pages fully inside the range
+    uintptr_t page = (uintptr_t)sysconf( _SC_PAGESIZE );
+    uintptr_t start = ( (uintptr_t)ptr + page - 1 ) & ~( page - 1 );
+    uintptr_t end = ( (uintptr_t)ptr + size ) & ~( page - 1 );
+    if( end <= start )
+    {
+        return false;
+    }
+    unsigned long mask = 1UL << node;
+    return syscall( SYS_mbind, start, end - start, MPOL_PREFERRED_MODE, &mask, NUMA_MAX_NODES + 1, 0 ) == 0;
+}
+
+static void add_cpu(int cpu, void* ctx)
+{
+    if( cpu < CPU_SETSIZE )
+    {
+        CPU_SET( cpu, (cpu_set_t*)ctx );
+    }
+}
+
+bool numa_bind_thread(int node)
+{
+    if( !numa_placement_active( node ) )
+    {
+        return false;
+    }
+    char path[64];
+    snprintf( path, sizeof( path ), "/sys/devices/system/node/node%d/cpulist", node );
+    cpu_set_t cpus;
+    CPU_ZERO( &cpus );
+    if( parse_sys_list( path, add_cpu, &cpus ) == 0 )
+    {
+        return false;
+    }
+    return sched_setaffinity( 0, sizeof( cpus ), &cpus ) == 0;
+}
@@ -0,0 +1,28 @@
+#ifndef NUMA_PLACE_H
+#define NUMA_PLACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Optional NUMA placement ---
+// Keeps a camera's frame memory and pipeline threads on one node so the
+// sensor and ISP never stream frames across the socket interconnect.
+// Uses the raw mbind/sched_setaffinity syscalls and /sys topology, no libnuma.
+// Every call is a no-op returning false when the machine has a single node
+// or the node is NUMA_NODE_ANY.
+#define NUMA_NODE_ANY -1
+
+// Number of online nodes, 1 when topology is unavailable
+int numa_node_count(void);
+
+// True when placement on 'node' would change anything on this machine
+bool numa_placement_active(int node);
+
+// Prefers 'node' for the pages of [ptr, ptr + size). Must run before the
+// memory is first touched; already-faulted pages are left where they are.
+bool numa_bind_memory(void* ptr, size_t size, int node);
+
+// Restricts the calling thread to the CPUs of 'node'
+bool numa_bind_thread(int node);
+
+#endif
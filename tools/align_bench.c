@@ -0,0 +1,285 @@
+#define _GNU_SOURCE
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "aligned_malloc.h"
+#include "huge_page.h"
+
+// Alignment / page-size sweep over frame-sized buffers.
+// For every alignment (unaligned, 16, 64, 4096) and page backing (4 KB,
+// huge) it times four access patterns over a 1920x1080x3 frame and prints
+// GB/s, cycles per byte and dTLB read misses. Cycles and TLB misses come
+// from perf_event_open; when the kernel refuses (perf_event_paranoid,
+// containers) those columns read n/a.
+//
+// Usage: align_bench [reps]
+
+#define FRAME_WIDTH     1920
+#define FRAME_HEIGHT    1080
+#define BYTE_PER_PIXEL  3
+#define FRAME_BYTES     ( FRAME_WIDTH * FRAME_HEIGHT * BYTE_PER_PIXEL )
+#define ROW_BYTES       ( FRAME_WIDTH * BYTE_PER_PIXEL )
+#define TILE            64              // Pixels per tile side
+#define STRIDE          4160            // Page + cache line: a new page and set every access
+#define DEFAULT_REPS    5
+#define SLACK_BYTES     8192            // Room to offset the pointer to an exact alignment
+
+typedef enum { BACKING_4K, BACKING_HUGE, BACKING_COUNT } backing_t;
+typedef enum { PATTERN_FILL, PATTERN_STRIDED, PATTERN_TILED, PATTERN_MEMCPY, PATTERN_COUNT } pattern_t;
+
+static const size_t alignments[] = { 1, 16, 64, 4096 };
+static const char* backing_names[BACKING_COUNT] = { "4KB", "huge" };
+static const char* pattern_names[PATTERN_COUNT] = { "seq fill", "strided", "tiled read", "memcpy" };
+
+typedef struct {
+    void* block;        // What to free
+    backing_t backing;
+    uint8_t* data;      // Aligned to exactly 'alignment' (not a larger power of 2)
+    page_mode_t mode;
+} bench_buffer_t;
+
+static volatile uint64_t sink;
+
+// --- perf counters ---
+
+typedef struct {
+    int cycles_fd;
+    int tlb_fd;
+} counters_t;
+
+static int open_counter(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset( &attr, 0, sizeof( attr ) );
+    attr.size = sizeof( attr );
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 );
+}
+
+static void counters_open(counters_t* c)
+{
+    c->cycles_fd = open_counter( PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES );
+    c->tlb_fd = open_counter( PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                              ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) |
+                              ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 ) );
+}
+
+static void counters_start(const counters_t* c)
+{
+    int fds[2] = { c->cycles_fd, c->tlb_fd };
+    for( int i = 0; i < 2; i++ )
+    {
+        if( fds[i] >= 0 )
+        {
+            ioctl( fds[i], PERF_EVENT_IOC_RESET, 0 );
+            ioctl( fds[i], PERF_EVENT_IOC_ENABLE, 0 );
+        }
+    }
+}
+
+static int64_t counter_stop(int fd)
+{
+    uint64_t value;
+    if( fd < 0 )
+    {
+        return -1;
+    }
+    ioctl( fd, PERF_EVENT_IOC_DISABLE, 0 );
+    return read( fd, &value, sizeof( value ) ) == sizeof( value ) ? (int64_t)value : -1;
+}
+
+// --- buffers ---
+
+static int buffer_create(bench_buffer_t* buf, size_t alignment, backing_t backing)
+{
+    size_t bytes = FRAME_BYTES + SLACK_BYTES;
+    uint8_t* base;
+    buf->backing = backing;
+    buf->mode = PAGE_MODE_NORMAL;
+    if( backing == BACKING_HUGE )
+    {
+        base = huge_page_alloc( bytes, &buf->mode );
+    }
+    else
+    {
+        base = aligned_malloc( bytes, 4096 );
+#ifdef MADV_NOHUGEPAGE
+        // Keep THP from quietly promoting the 4 KB baseline
+        uintptr_t start = (uintptr_t)base & ~(uintptr_t)4095;
+        madvise( (void*)start, bytes, MADV_NOHUGEPAGE );
+#endif
+    }
+    if( !base )
+    {
+        return -1;
+    }
+    buf->block = base;
+    // base is at least 4096 aligned; offset by the alignment so the pointer has
+    // that alignment and no more (4096 stays on the page boundary)
+    buf->data = base + ( alignment < 4096 ? alignment : 0 );
+    if( alignment >= 4096 && ( (uintptr_t)base & 8191 ) == 0 )
+    {
+        buf->data += 4096;
+    }
+    // Fault everything in so the timed passes measure access, not page faults
+    memset( buf->data, 1, FRAME_BYTES );
+    if( backing == BACKING_HUGE )
+    {
+        buf->mode = huge_page_verify( base, buf->mode );
+    }
+    return 0;
+}
+
+static void buffer_destroy(bench_buffer_t* buf)
+{
+    if( buf->backing == BACKING_HUGE )
+    {
+        huge_page_free( buf->block, FRAME_BYTES + SLACK_BYTES );
+    }
+    else
+    {
+        free_aligned( buf->block );
+    }
+}
+
+// --- patterns ---
+
+static void run_pattern(pattern_t pattern, uint8_t* data, uint8_t* other, uint32_t seed)
+{
+    uint64_t sum = 0;
+    switch( pattern )
+    {
+        case PATTERN_FILL:
+            // Same loop shape as simulate_sensor_capture
+            for( size_t i = 0; i < FRAME_BYTES; i++ )
+            {
+                data[i] = (uint8_t)( ( i + seed ) % 256 );
+            }
+            break;
+        case PATTERN_STRIDED:
+            // Walk the frame in STRIDE steps, wrapping with a shifting start, so
+            // every byte is read once but neighbours are touched far apart
+            for( size_t start = 0; start < STRIDE; start++ )
+            {
+                for( size_t i = start; i < FRAME_BYTES; i += STRIDE )
+                {
+                    sum += data[i];
+                }
+            }
+            break;
+        case PATTERN_TILED:
+            for( size_t ty = 0; ty < FRAME_HEIGHT; ty += TILE )
+            {
+                for( size_t tx = 0; tx < FRAME_WIDTH; tx += TILE )
+                {
+                    size_t h = ( ty + TILE <= FRAME_HEIGHT ) ? TILE : FRAME_HEIGHT - ty;
+                    size_t w = ( tx + TILE <= FRAME_WIDTH ) ? TILE : FRAME_WIDTH - tx;
+                    for( size_t y = 0; y < h; y++ )
+                    {
+                        const uint8_t* row = data + ( ty + y ) * ROW_BYTES + tx * BYTE_PER_PIXEL;
+                        for( size_t x = 0; x < w * BYTE_PER_PIXEL; x++ )
+                        {
+                            sum += row[x];
+                        }
+                    }
+                }
+            }
+            break;
+        case PATTERN_MEMCPY:
+            memcpy( other, data, FRAME_BYTES );
+            sum = other[seed % FRAME_BYTES];
+            break;
+        default:
+            break;
+    }
+    sink += sum;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+    int reps = argc > 1 ? atoi( argv[1] ) : DEFAULT_REPS;
+    if( reps <= 0 )
+    {
+        printf("Usage: align_bench [reps]\n");
+        return 1;
+    }
+
+    counters_t counters;
+    counters_open( &counters );
+    printf("Frame %d bytes, best of %d reps, perf counters %s\n", FRAME_BYTES, reps,
+           counters.cycles_fd >= 0 ? "available" : "unavailable");
+    printf("%-6s %-5s %-22s %-11s %8s %8s %12s\n", "align", "pages", "backing", "pattern", "GB/s",
+           "cyc/B", "dTLB miss");
+
+    for( size_t a = 0; a < sizeof( alignments ) / sizeof( alignments[0] ); a++ )
+    {
+        for( int backing = 0; backing < BACKING_COUNT; backing++ )
+        {
+            bench_buffer_t src, dst;
+            if( buffer_create( &src, alignments[a], backing ) != 0 ||
+                buffer_create( &dst, alignments[a], backing ) != 0 )
+            {
+                printf("Allocation failed\n");
+                return 1;
+            }
+            for( int pattern = 0; pattern < PATTERN_COUNT; pattern++ )
+            {
+                uint64_t best_ns = UINT64_MAX;
+                int64_t best_cycles = -1;
+                int64_t best_tlb = -1;
+                for( int r = 0; r < reps; r++ )
+                {
+                    counters_start( &counters );
+                    uint64_t start = now_ns();
+                    run_pattern( pattern, src.data, dst.data, (uint32_t)r );
+                    uint64_t elapsed = now_ns() - start;
+                    int64_t cycles = counter_stop( counters.cycles_fd );
+                    int64_t tlb = counter_stop( counters.tlb_fd );
+                    if( elapsed < best_ns )
+                    {
+                        best_ns = elapsed;
+                        best_cycles = cycles;
+                        best_tlb = tlb;
+                    }
+                }
+                // memcpy reads and writes every byte
+                double bytes = (double)FRAME_BYTES * ( pattern == PATTERN_MEMCPY ? 2 : 1 );
+                char cyc[16] = "n/a";
+                char tlb[24] = "n/a";
+                if( best_cycles >= 0 )
+                {
+                    snprintf( cyc, sizeof( cyc ), "%.3f", best_cycles / bytes );
+                }
+                if( best_tlb >= 0 )
+                {
+                    snprintf( tlb, sizeof( tlb ), "%lld", (long long)best_tlb );
+                }
+                printf("%-6zu %-5s %-22s %-11s %8.2f %8s %12s\n", alignments[a], backing_names[backing],
+                       backing == BACKING_HUGE ? page_mode_name( src.mode ) : "aligned_malloc",
+                       pattern_names[pattern], bytes / best_ns, cyc, tlb);
+            }
+            buffer_destroy( &src );
+            buffer_destroy( &dst );
+        }
+    }
+    return 0;
+}
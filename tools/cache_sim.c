@@ -0,0 +1,481 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Trace-driven cache sizing simulator.
+// Replays a lens_id access trace (one id per line, as written by LumaStream
+// with LUMA_LENS_TRACE set) and prints miss-ratio curves over cache sizes.
+//
+// LRU uses reuse-distance analysis, so one pass gives the whole curve. With
+// --sample R < 1 only keys whose hash falls below R are tracked and distances
+// are scaled by 1/R (SHARDS), which keeps large traces fast and small.
+// FIFO, CLOCK and RANDOM have no stack property and are simulated per size;
+// when sampling they replay the same sampled keys into a cache scaled by R,
+// so every curve is the same kind of estimate.
+//
+// Usage: cache_sim <trace> [--max-size N] [--sample R] [--entry-bytes B] [--miss-us U]
+
+#define DEFAULT_MAX_SIZE     16
+#define DEFAULT_ENTRY_BYTES  128    // 64B LensProfile_t + Node + HashNode
+#define DEFAULT_MISS_US      20000  // simulated EEPROM read
+#define SAMPLE_MODULUS       (1u << 24)
+#define EMPTY_KEY            UINT32_MAX
+
+enum { POLICY_LRU, POLICY_FIFO, POLICY_CLOCK, POLICY_RANDOM, POLICY_COUNT };
+static const char* policy_names[POLICY_COUNT] = { "LRU", "FIFO", "CLOCK", "RANDOM" };
+
+// --- Open addressing map: key -> int, linear probing, backward-shift delete ---
+
+typedef struct {
+    uint32_t* keys;
+    int64_t* values;
+    size_t mask;
+} key_map_t;
+
+static uint32_t mix32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static int key_map_init(key_map_t* map, size_t min_entries)
+{
+    size_t size = 16;
+    while( size < min_entries * 2 )
+    {
+        size <<= 1;
+    }
+    map->keys = malloc( size * sizeof(uint32_t) );
+    map->values = malloc( size * sizeof(int64_t) );
+    map->mask = size - 1;
+    if( !map->keys || !map->values )
+    {
+        return -1;
+    }
+    memset( map->keys, 0xFF, size * sizeof(uint32_t) );
+    return 0;
+}
+
+static void key_map_destroy(key_map_t* map)
+{
+    free( map->keys );
+    free( map->values );
+}
+
+static int64_t* key_map_find(key_map_t* map, uint32_t key)
+{
+    for( size_t i = mix32( key ) & map->mask; map->keys[i] != EMPTY_KEY; i = ( i + 1 ) & map->mask )
+    {
+        if( map->keys[i] == key )
+        {
+            return &map->values[i];
+        }
+    }
+    return NULL;
+}
+
+static void key_map_put(key_map_t* map, uint32_t key, int64_t value)
+{
+    size_t i = mix32( key ) & map->mask;
+    while( map->keys[i] != EMPTY_KEY && map->keys[i] != key )
+    {
+        i = ( i + 1 ) & map->mask;
+    }
+    map->keys[i] = key;
+    map->values[i] = value;
+}
+
+static void key_map_erase(key_map_t* map, uint32_t key)
+{
+    size_t i = mix32( key ) & map->mask;
+    while( map->keys[i] != key )
+    {
+        if( map->keys[i] == EMPTY_KEY )
+        {
+            return;
+        }
+        i = ( i + 1 ) & map->mask;
+    }
+    // Shift later entries of the probe run back so lookups never stop early
+    size_t hole = i;
+    for( size_t j = ( i + 1 ) & map->mask; map->keys[j] != EMPTY_KEY; j = ( j + 1 ) & map->mask )
+    {
+        size_t home = mix32( map->keys[j] ) & map->mask;
+        if( ( ( j - home ) & map->mask ) >= ( ( j - hole ) & map->mask ) )
+        {
+            map->keys[hole] = map->keys[j];
+            map->values[hole] = map->values[j];
+            hole = j;
+        }
+    }
+    map->keys[hole] = EMPTY_KEY;
+}
+
+// --- Trace loading ---
+
+static uint32_t* load_trace(const char* path, size_t* count)
+{
+    FILE* file = fopen( path, "r" );
+    if( !file )
+    {
+        return NULL;
+    }
+    size_t capacity = 4096;
+    size_t n = 0;
+    uint32_t* keys = malloc( capacity * sizeof(uint32_t) );
+    unsigned long key;
+    while( keys && fscanf( file, "%lu", &key ) == 1 )
+    {
+        if( n == capacity )
+        {
+            capacity *= 2;
+            uint32_t* grown = realloc( keys, capacity * sizeof(uint32_t) );
+            if( !grown )
+            {
+                free( keys );
+                keys = NULL;
+                break;
+            }
+            keys = grown;
+        }
+        keys[n++] = (uint32_t)key;
+    }
+    fclose( file );
+    *count = n;
+    return keys;
+}
+
+// --- LRU miss-ratio curve from sampled reuse distances ---
+
+// Fenwick tree over access times; a 1 marks the latest access of some key, so
+// the marks after a key's previous access count the distinct keys since then
+static void fenwick_add(int32_t* tree, size_t n, size_t pos, int32_t delta)
+{
+    for( pos++; pos <= n; pos += pos & -pos )
+    {
+        tree[pos - 1] += delta;
+    }
+}
+
+static int64_t fenwick_prefix(const int32_t* tree, size_t pos)
+{
+    int64_t sum = 0;
+    for( pos++; pos > 0; pos -= pos & -pos )
+    {
+        sum += tree[pos - 1];
+    }
+    return sum;
+}
+
+// Keys whose mixed hash falls below this are sampled
+static uint32_t sample_threshold(double sample_rate)
+{
+    return sample_rate >= 1.0 ? SAMPLE_MODULUS : (uint32_t)( sample_rate * SAMPLE_MODULUS );
+}
+
+static bool key_sampled(uint32_t key, uint32_t threshold)
+{
+    return ( mix32( key ) % SAMPLE_MODULUS ) < threshold;
+}
+
+static int lru_curve(const uint32_t* trace, size_t count, double sample_rate,
+                     uint32_t max_size, double* miss_ratio)
+{
+    uint32_t threshold = sample_threshold( sample_rate );
+    int32_t* tree = calloc( count ? count : 1, sizeof(int32_t) );
+    // hist[d] for d < max_size counts sampled reuses at distance d
+    double* hist = calloc( max_size, sizeof(double) );
+    key_map_t last_access;
+    if( !tree || !hist || key_map_init( &last_access, 1024 ) != 0 )
+    {
+        free( tree );
+        free( hist );
+        return -1;
+    }
+
+    size_t sampled = 0;
+    size_t distinct = 0;
+    size_t t = 0;
+    for( size_t i = 0; i < count; i++ )
+    {
+        if( !key_sampled( trace[i], threshold ) )
+        {
+            continue;
+        }
+        int64_t* prev = key_map_find( &last_access, trace[i] );
+        if( prev )
+        {
+            int64_t distance = fenwick_prefix( tree, t ) - fenwick_prefix( tree, (size_t)*prev );
+            double scaled = (double)distance / ( (double)threshold / SAMPLE_MODULUS );
+            if( scaled < max_size )
+            {
+                hist[(size_t)scaled] += 1.0;
+            }
+            fenwick_add( tree, count, (size_t)*prev, -1 );
+            *prev = (int64_t)t;
+        }
+        else
+        {
+            if( distinct * 2 >= last_access.mask )
+            {
+                // Rehash into a map twice the size
+                key_map_t grown;
+                if( key_map_init( &grown, distinct * 2 ) != 0 )
+                {
+                    break;
+                }
+                for( size_t s = 0; s <= last_access.mask; s++ )
+                {
+                    if( last_access.keys[s] != EMPTY_KEY )
+                    {
+                        key_map_put( &grown, last_access.keys[s], last_access.values[s] );
+                    }
+                }
+                key_map_destroy( &last_access );
+                last_access = grown;
+            }
+            key_map_put( &last_access, trace[i], (int64_t)t );
+            distinct++;
+        }
+        fenwick_add( tree, count, t, 1 );
+        sampled++;
+        t++;
+    }
+
+    // A cache of size C hits every reuse at distance < C
+    double hits = 0.0;
+    for( uint32_t size = 1; size <= max_size; size++ )
+    {
+        hits += hist[size - 1];
+        miss_ratio[size - 1] = sampled ? 1.0 - hits / sampled : 0.0;
+    }
+
+    key_map_destroy( &last_access );
+    free( tree );
+    free( hist );
+    return 0;
+}
+
+// --- Direct simulation for policies without the stack property ---
+
+static double simulate_policy(const uint32_t* trace, size_t count, int policy, uint32_t size)
+{
+    uint32_t* slots = malloc( size * sizeof(uint32_t) );
+    uint8_t* referenced = calloc( size, 1 );
+    key_map_t where;
+    if( !slots || !referenced || key_map_init( &where, size ) != 0 )
+    {
+        free( slots );
+        free( referenced );
+        return -1.0;
+    }
+
+    uint32_t used = 0;
+    uint32_t hand = 0;          // FIFO insertion point / CLOCK hand
+    uint32_t rng = 0x9E3779B9u;
+    size_t misses = 0;
+    for( size_t i = 0; i < count; i++ )
+    {
+        int64_t* slot = key_map_find( &where, trace[i] );
+        if( slot )
+        {
+            referenced[*slot] = 1;
+            continue;
+        }
+        misses++;
+
+        uint32_t victim;
+        if( used < size )
+        {
+            victim = used++;
+            slots[victim] = EMPTY_KEY;
+        }
+        else if( policy == POLICY_FIFO )
+        {
+            victim = hand;
+            hand = ( hand + 1 ) % size;
+        }
+        else if( policy == POLICY_CLOCK )
+        {
+            while( referenced[hand] )
+            {
+                referenced[hand] = 0;
+                hand = ( hand + 1 ) % size;
+            }
+            victim = hand;
+            hand = ( hand + 1 ) % size;
+        }
+        else
+        {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            victim = rng % size;
+        }
+
+        if( slots[victim] != EMPTY_KEY )
+        {
+            key_map_erase( &where, slots[victim] );
+        }
+        slots[victim] = trace[i];
+        referenced[victim] = 0;
+        key_map_put( &where, trace[i], victim );
+    }
+
+    key_map_destroy( &where );
+    free( slots );
+    free( referenced );
+    return count ? (double)misses / count : 0.0;
+}
+
+// Miss-ratio curve of a policy without the stack property. Sampling keeps the
+// accesses to sampled keys, in order, and shrinks each cache by the same rate,
+// as the LRU curve does through its scaled distances.
+static int policy_curve(const uint32_t* trace, size_t count, int policy, double sample_rate,
+                        uint32_t max_size, double* miss_ratio)
+{
+    uint32_t threshold = sample_threshold( sample_rate );
+    const uint32_t* replay = trace;
+    uint32_t* sampled = NULL;
+    size_t replay_count = count;
+    if( threshold < SAMPLE_MODULUS )
+    {
+        sampled = malloc( ( count ? count : 1 ) * sizeof(uint32_t) );
+        if( !sampled )
+        {
+            return -1;
+        }
+        replay_count = 0;
+        for( size_t i = 0; i < count; i++ )
+        {
+            if( key_sampled( trace[i], threshold ) )
+            {
+                sampled[replay_count++] = trace[i];
+            }
+        }
+        replay = sampled;
+    }
+
+    double rate = (double)threshold / SAMPLE_MODULUS;
+    for( uint32_t size = 1; size <= max_size; size++ )
+    {
+        uint32_t scaled = (uint32_t)( size * rate + 0.5 );
+        // A cache scaled below one entry holds nothing
+        miss_ratio[size - 1] = scaled ? simulate_policy( replay, replay_count, policy, scaled ) : 1.0;
+    }
+    free( sampled );
+    return 0;
+}
+
+static void usage(void)
+{
+    printf("Usage: cache_sim <trace> [--max-size N] [--sample R] [--entry-bytes B] [--miss-us U]\n");
+}
+
+int main(int argc, char** argv)
+{
+    if( argc < 2 )
+    {
+        usage();
+        return 1;
+    }
+    const char* path = argv[1];
+    uint32_t max_size = DEFAULT_MAX_SIZE;
+    double sample_rate = 1.0;
+    double entry_bytes = DEFAULT_ENTRY_BYTES;
+    double miss_us = DEFAULT_MISS_US;
+    for( int i = 2; i + 1 < argc; i += 2 )
+    {
+        if( strcmp( argv[i], "--max-size" ) == 0 )        max_size = (uint32_t)strtoul( argv[i + 1], NULL, 10 );
+        else if( strcmp( argv[i], "--sample" ) == 0 )     sample_rate = strtod( argv[i + 1], NULL );
+        else if( strcmp( argv[i], "--entry-bytes" ) == 0 ) entry_bytes = strtod( argv[i + 1], NULL );
+        else if( strcmp( argv[i], "--miss-us" ) == 0 )    miss_us = strtod( argv[i + 1], NULL );
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if( max_size == 0 || sample_rate <= 0.0 )
+    {
+        usage();
+        return 1;
+    }
+
+    size_t count = 0;
+    uint32_t* trace = load_trace( path, &count );
+    if( !trace )
+    {
+        printf("Could not read trace %s\n", path);
+        return 1;
+    }
+
+    double* curves[POLICY_COUNT];
+    for( int p = 0; p < POLICY_COUNT; p++ )
+    {
+        curves[p] = calloc( max_size, sizeof(double) );
+    }
+    lru_curve( trace, count, sample_rate, max_size, curves[POLICY_LRU] );
+    for( int p = POLICY_FIFO; p < POLICY_COUNT; p++ )
+    {
+        policy_curve( trace, count, p, sample_rate, max_size, curves[p] );
+    }
+
+    printf("Trace: %s, %zu accesses, sample rate %.3f\n", path, count, sample_rate);
+    printf("%5s %9s", "size", "KB");
+    for( int p = 0; p < POLICY_COUNT; p++ )
+    {
+        printf(" %8s", policy_names[p]);
+    }
+    printf(" %12s %12s\n", "best us/acc", "gain us/KB");
+
+    // Pick the smallest size whose best miss cost is within 1% of the largest size's
+    double floor_us = 1e300;
+    for( int p = 0; p < POLICY_COUNT; p++ )
+    {
+        if( curves[p][max_size - 1] * miss_us < floor_us )
+        {
+            floor_us = curves[p][max_size - 1] * miss_us;
+        }
+    }
+    uint32_t pick_size = max_size;
+    int pick_policy = POLICY_LRU;
+    double prev_us = miss_us;
+    for( uint32_t size = 1; size <= max_size; size++ )
+    {
+        int best = POLICY_LRU;
+        printf("%5u %9.2f", size, size * entry_bytes / 1024.0);
+        for( int p = 0; p < POLICY_COUNT; p++ )
+        {
+            printf(" %8.4f", curves[p][size - 1]);
+            if( curves[p][size - 1] < curves[best][size - 1] )
+            {
+                best = p;
+            }
+        }
+        double best_us = curves[best][size - 1] * miss_us;
+        // Expected miss latency saved per access by the last entry, per KB it costs
+        printf(" %12.1f %12.1f\n", best_us, ( prev_us - best_us ) / ( entry_bytes / 1024.0 ));
+        prev_us = best_us;
+        if( pick_size == max_size && best_us <= floor_us * 1.01 )
+        {
+            pick_size = size;
+            pick_policy = best;
+        }
+    }
+    printf("Recommended: %u entries (%.2f KB) with %s\n", pick_size, pick_size * entry_bytes / 1024.0,
+           policy_names[pick_policy]);
+
+    for( int p = 0; p < POLICY_COUNT; p++ )
+    {
+        free( curves[p] );
+    }
+    free( trace );
+    return 0;
+}
@@ -0,0 +1,291 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "aligned_malloc.h"
+#include "isp_gain.h"
+#include "sensor_fill.h"
+#include "lens_remap.h"
+
+// Full-frame ISP kernel throughput per variant and instruction set.
+// Gain passes run over a 1920x1080x3 frame restored from a noisy source
+// between passes, so the clamp branch in the reference sees real data.
+// Sensor fill passes also time re-reading a cache-sized ISP working set
+// afterwards, to show what cached stores evict and streaming stores keep.
+// Lens correction times the table build once and the remap pass per frame,
+// using the widest lens from tools/gen_lens_db.
+// Cycles are TSC ticks (constant rate, not core clock), so B/cycle is
+// comparable between variants but shifts with turbo.
+//
+// Usage: isp_bench [reps] [gain]
+
+#define FRAME_W       1920
+#define FRAME_H       1080
+#define FRAME_BYTES   ( FRAME_W * FRAME_H * 3 )
+#define DEFAULT_REPS  10
+#define DEFAULT_GAIN  1.5f
+#define FRAME_BUDGET_MS 16.667   // One frame interval at 60 fps
+#define WORKING_SET     ( 512 * 1024 )  // Stand-in for ISP tables and scratch
+#define FILL_NOISE_BITS 4
+
+typedef enum { VARIANT_REFERENCE, VARIANT_FLOAT, VARIANT_FIXED, VARIANT_LUT, VARIANT_COUNT } variant_t;
+static const char* variant_names[VARIANT_COUNT] = { "reference", "float", "fixed Q8.8", "LUT" };
+
+typedef enum { FILL_REFERENCE, FILL_CACHED, FILL_STREAM, FILL_STREAM_NOISE, FILL_COUNT } fill_t;
+static const char* fill_names[FILL_COUNT] = { "reference", "cached", "stream", "stream+noise" };
+
+static volatile uint64_t sink;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t ticks(void)
+{
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void run_fill(fill_t fill, uint8_t* data, uint32_t rep)
+{
+    switch( fill )
+    {
+        case FILL_REFERENCE:
+            // The loop simulate_sensor_capture used to run
+            for( size_t i = 0; i < FRAME_BYTES; i++ )
+            {
+                data[i] = (uint8_t)( ( i + rep ) % 256 );
+            }
+            break;
+        case FILL_CACHED:
+            sensor_fill( data, FRAME_BYTES, (uint8_t)rep, rep, 0, false );
+            break;
+        case FILL_STREAM:
+            sensor_fill( data, FRAME_BYTES, (uint8_t)rep, rep, 0, true );
+            break;
+        case FILL_STREAM_NOISE:
+            sensor_fill( data, FRAME_BYTES, (uint8_t)rep, rep, FILL_NOISE_BITS, true );
+            break;
+        default:
+            break;
+    }
+}
+
+static uint64_t read_working_set(const uint8_t* set)
+{
+    uint64_t sum = 0;
+    for( size_t i = 0; i < WORKING_SET; i += 64 )
+    {
+        sum += set[i];
+    }
+    return sum;
+}
+
+static void run_variant(variant_t variant, uint8_t* data, float gain, const uint8_t* lut)
+{
+    switch( variant )
+    {
+        case VARIANT_REFERENCE:
+            gain_apply_reference( data, FRAME_BYTES, gain );
+            break;
+        case VARIANT_FLOAT:
+            gain_apply_float( data, FRAME_BYTES, gain );
+            break;
+        case VARIANT_FIXED:
+            gain_apply_fixed( data, FRAME_BYTES, gain_to_fixed( gain ) );
+            break;
+        case VARIANT_LUT:
+            gain_apply_lut( data, FRAME_BYTES, lut );
+            break;
+        default:
+            break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int reps = argc > 1 ? atoi( argv[1] ) : DEFAULT_REPS;
+    float gain = argc > 2 ? (float)atof( argv[2] ) : DEFAULT_GAIN;
+    if( reps <= 0 || gain < 0.0f || gain >= 256.0f )
+    {
+        printf("Usage: isp_bench [reps] [gain]\n");
+        return 1;
+    }
+
+    // Padded for the remap gathers
+    uint8_t* source = aligned_malloc( FRAME_BYTES + LENS_REMAP_SRC_PAD, 64 );
+    uint8_t* frame = aligned_malloc( FRAME_BYTES, 64 );
+    if( !source || !frame )
+    {
+        printf("Allocation failed\n");
+        return 1;
+    }
+    uint32_t state = 2463534242u;
+    for( size_t i = 0; i < FRAME_BYTES; i++ )
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        source[i] = (uint8_t)state;
+    }
+    memset( source + FRAME_BYTES, 0, LENS_REMAP_SRC_PAD );
+    uint8_t lut[256];
+    gain_build_lut( lut, gain );
+
+    printf("Frame %d bytes, gain %.2f, best of %d reps, CPU supports up to %s\n",
+           FRAME_BYTES, gain, reps, isp_isa_name( isp_isa_active() ));
+    printf("%-7s %-11s %9s %8s %10s %8s\n", "isa", "kernel", "B/cycle", "GB/s", "ms/frame", "of 60fps");
+
+    for( int isa = 0; isa < ISP_ISA_COUNT; isa++ )
+    {
+        if( !isp_isa_select( isa ) )
+        {
+            continue;
+        }
+        for( int variant = 0; variant < VARIANT_COUNT; variant++ )
+        {
+            // Reference and LUT do not dispatch; time them once
+            if( isa != ISP_ISA_SCALAR && ( variant == VARIANT_REFERENCE || variant == VARIANT_LUT ) )
+            {
+                continue;
+            }
+            uint64_t best_ns = UINT64_MAX;
+            uint64_t best_ticks = 0;
+            for( int r = 0; r < reps; r++ )
+            {
+                memcpy( frame, source, FRAME_BYTES );
+                uint64_t start_ticks = ticks();
+                uint64_t start = now_ns();
+                run_variant( variant, frame, gain, lut );
+                uint64_t elapsed = now_ns() - start;
+                uint64_t elapsed_ticks = ticks() - start_ticks;
+                if( elapsed < best_ns )
+                {
+                    best_ns = elapsed;
+                    best_ticks = elapsed_ticks;
+                }
+            }
+            char per_cycle[16] = "n/a";
+            if( best_ticks )
+            {
+                snprintf( per_cycle, sizeof( per_cycle ), "%.3f", (double)FRAME_BYTES / best_ticks );
+            }
+            double ms = best_ns / 1e6;
+            printf("%-7s %-11s %9s %8.2f %10.3f %7.1f%%\n", isp_isa_name( isa ), variant_names[variant],
+                   per_cycle, (double)FRAME_BYTES / best_ns, ms, 100.0 * ms / FRAME_BUDGET_MS);
+        }
+    }
+    uint8_t* working_set = aligned_malloc( WORKING_SET, 64 );
+    if( !working_set )
+    {
+        printf("Allocation failed\n");
+        return 1;
+    }
+    memset( working_set, 1, WORKING_SET );
+    printf("\nSensor fill, then one read of a %d KB warm working set\n", WORKING_SET / 1024);
+    printf("%-7s %-13s %9s %8s %10s %12s\n", "isa", "fill", "B/cycle", "GB/s", "ms/frame", "reread us");
+    for( int isa = 0; isa < ISP_ISA_COUNT; isa++ )
+    {
+        if( !isp_isa_select( isa ) )
+        {
+            continue;
+        }
+        for( int fill = 0; fill < FILL_COUNT; fill++ )
+        {
+            if( isa != ISP_ISA_SCALAR && fill == FILL_REFERENCE )
+            {
+                continue;
+            }
+            uint64_t best_ns = UINT64_MAX;
+            uint64_t best_ticks = 0;
+            uint64_t best_reread = UINT64_MAX;
+            for( int r = 0; r < reps; r++ )
+            {
+                sink += read_working_set( working_set );
+                uint64_t start_ticks = ticks();
+                uint64_t start = now_ns();
+                run_fill( fill, frame, (uint32_t)r );
+                uint64_t elapsed = now_ns() - start;
+                uint64_t elapsed_ticks = ticks() - start_ticks;
+                uint64_t reread_start = now_ns();
+                sink += read_working_set( working_set );
+                uint64_t reread = now_ns() - reread_start;
+                if( elapsed < best_ns )
+                {
+                    best_ns = elapsed;
+                    best_ticks = elapsed_ticks;
+                }
+                best_reread = reread < best_reread ? reread : best_reread;
+            }
+            char per_cycle[16] = "n/a";
+            if( best_ticks )
+            {
+                snprintf( per_cycle, sizeof( per_cycle ), "%.3f", (double)FRAME_BYTES / best_ticks );
+            }
+            printf("%-7s %-13s %9s %8.2f %10.3f %12.1f\n", isp_isa_name( isa ), fill_names[fill], per_cycle,
+                   (double)FRAME_BYTES / best_ns, best_ns / 1e6, best_reread / 1e3);
+        }
+    }
+    free_aligned( working_set );
+
+    lens_model_t model = { { -0.30f, 0.08f, -0.01f, 0, 0, 0 }, { 0.45f, 0.10f, 0 }, gain };
+    size_t table_size = lens_remap_size( FRAME_W, FRAME_H );
+    lens_remap_t* table = aligned_malloc( table_size, 64 );
+    if( !table )
+    {
+        printf("Allocation failed\n");
+        return 1;
+    }
+    uint64_t build_start = now_ns();
+    lens_remap_build( table, 0, &model, FRAME_W, FRAME_H );
+    uint64_t build_ns = now_ns() - build_start;
+    printf("\nLens correction, %zu KB table built once in %.3f ms\n", table_size / 1024, build_ns / 1e6);
+    printf("%-7s %-13s %9s %8s %10s %8s\n", "isa", "pass", "B/cycle", "GB/s", "ms/frame", "of 60fps");
+    for( int isa = 0; isa < ISP_ISA_COUNT; isa++ )
+    {
+        if( !isp_isa_select( isa ) )
+        {
+            continue;
+        }
+        uint64_t best_ns = UINT64_MAX;
+        uint64_t best_ticks = 0;
+        for( int r = 0; r < reps; r++ )
+        {
+            uint64_t start_ticks = ticks();
+            uint64_t start = now_ns();
+            lens_remap_apply( table, source, frame, 0, 0, FRAME_W, FRAME_H );
+            uint64_t elapsed = now_ns() - start;
+            uint64_t elapsed_ticks = ticks() - start_ticks;
+            if( elapsed < best_ns )
+            {
+                best_ns = elapsed;
+                best_ticks = elapsed_ticks;
+            }
+        }
+        char per_cycle[16] = "n/a";
+        if( best_ticks )
+        {
+            snprintf( per_cycle, sizeof( per_cycle ), "%.3f", (double)FRAME_BYTES / best_ticks );
+        }
+        double ms = best_ns / 1e6;
+        printf("%-7s %-13s %9s %8.2f %10.3f %7.1f%%\n", isp_isa_name( isa ), "remap+vignette", per_cycle,
+               (double)FRAME_BYTES / best_ns, ms, 100.0 * ms / FRAME_BUDGET_MS);
+    }
+    free_aligned( table );
+    free_aligned( source );
+    free_aligned( frame );
+    return 0;
+}